@@ -0,0 +1,176 @@
+#include "adaptive.h"
+
+#include <algorithm>
+#include <cmath>
+
+static std::string AccumulateVertexSource =
+"# version 330 core\n"
+"out vec2 uv;\n"
+"void main()\n"
+"{\n"
+"    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"         // full-screen triangle
+"    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);\n"
+"};\n";
+
+static std::string AccumulateFragmentSource =
+"# version 330 core\n"
+"in vec2 uv;\n"
+"uniform sampler2D frame;\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"    color = texture(frame, uv);\n"
+"};\n";
+
+#define ACCUMULATE_UNIT 8
+
+/// Radical inverse of i in the given base (Halton sequence), used for well distributed sub-pixel offsets
+static float Halton(int i, int base) {
+    float f = 1.0f, r = 0.0f;
+    for (; i > 0; i /= base) {
+        f /= (float)base;
+        r += f * (float)(i % base);
+    }
+    return r;
+}
+
+void glAdaptiveView::ReadQuery() {
+    if (!query_pending) return;
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return;                                             // try again next frame
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+    query_pending = false;
+
+    // the cost of the view is dominated by fragments, so it scales with the number of pixels
+    float ms = (float)((double)ns * 1e-6) / (query_scale * query_scale);
+    full_ms = (full_ms == 0.0f) ? ms : 0.7f * full_ms + 0.3f * ms;
+}
+
+bool glAdaptiveView::InitAccumulation() {
+    if (!target.Resize(w, h) || !accumulation.Resize(w, h, GL_RGBA16F)) return false;
+    if (vao == 0) glGenVertexArrays(1, &vao);
+    if (shader == nullptr) shader = new glProgram(AccumulateVertexSource, AccumulateFragmentSource);
+    return true;
+}
+
+bool glAdaptiveView::Begin(int vx, int vy, int vw, int vh, bool interacting, bool changed) {
+    if (interacting || changed || vw != w || vh != h) samples = 0;
+    x = vx;
+    y = vy;
+    w = vw;
+    h = vh;
+    if (query == 0) glGenQueries(1, &query);
+    ReadQuery();
+
+    mode = DIRECT;
+    scale = 1.0f;
+    jitter = glm::vec2(0.0f);
+    if (interacting) {
+        if (enable && full_ms > target_ms) {
+            float s = std::sqrt(target_ms / full_ms);
+            s = std::floor(s * 8.0f) / 8.0f;                            // steps of 1/8 so the target is rarely re-allocated
+            s = std::clamp(s, min_scale, 1.0f);
+            if (s < 1.0f && target.Resize(std::max(1, (int)(w * s)), std::max(1, (int)(h * s)))) {
+                mode = REDUCED;
+                scale = s;
+            }
+        }
+    }
+    else if (progressive) {
+        if (samples >= max_samples) {
+            mode = CONVERGED;
+            return false;
+        }
+        if (InitAccumulation()) {
+            mode = REFINE;
+            if (samples > 0) jitter = glm::vec2(Halton(samples, 2), Halton(samples, 3)) - glm::vec2(0.5f);
+        }
+    }
+
+    timing = !query_pending;                                            // only one query in flight
+    if (timing) {
+        query_scale = scale;
+        glBeginQuery(GL_TIME_ELAPSED, query);
+    }
+
+    if (mode == DIRECT)
+        glViewport(x, y, w, h);
+    else {
+        target.Bind();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    return true;
+}
+
+glm::mat4 glAdaptiveView::Jitter() const {
+    if (mode != REFINE) return glm::mat4(1.0f);
+    return glm::translate(glm::mat4(1.0f), glm::vec3(2.0f * jitter.x / (float)w, 2.0f * jitter.y / (float)h, 0.0f));
+}
+
+void glAdaptiveView::Accumulate() {
+    GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+
+    accumulation.Bind();
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);        // running average: the new frame has weight 1 / n
+    glBlendColor(0.0f, 0.0f, 0.0f, 1.0f / (float)(samples + 1));
+    glActiveTexture(GL_TEXTURE0 + ACCUMULATE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, target.ColorTexture());
+    glActiveTexture(GL_TEXTURE0);
+
+    shader->Bind();
+    shader->SetUniform1i("frame", ACCUMULATE_UNIT);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    accumulation.Unbind();
+    samples++;
+
+    if (!blend) glDisable(GL_BLEND);
+    if (depth_test) glEnable(GL_DEPTH_TEST);
+}
+
+void glAdaptiveView::Present(const glFramebuffer& source) {
+    GLint draw;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &draw);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source.ID());
+    glBlitFramebuffer(0, 0, source.Width(), source.Height(), x, y, x + w, y + h, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, draw);
+}
+
+void glAdaptiveView::End() {
+    if (mode == REDUCED) {
+        target.Unbind();
+        Present(target);
+    }
+    else if (mode == REFINE) {
+        target.Unbind();
+        Accumulate();
+        Present(accumulation);
+    }
+    else if (mode == CONVERGED)
+        Present(accumulation);
+    glViewport(x, y, w, h);
+
+    if (timing) {
+        glEndQuery(GL_TIME_ELAPSED);
+        query_pending = true;
+        timing = false;
+    }
+}
+
+void glAdaptiveView::Destroy() {
+    target.Destroy();
+    accumulation.Destroy();
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (query) glDeleteQueries(1, &query);
+    delete shader;
+    vao = query = 0;
+    shader = nullptr;
+    query_pending = false;
+    samples = 0;
+}
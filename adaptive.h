@@ -0,0 +1,74 @@
+#pragma once
+
+#include "tira/graphics_gl.h"
+#include "program.h"
+#include "framebuffer.h"
+
+/// <summary>
+/// Renders a viewport at a resolution and quality adapted to what the user is doing.
+/// While the user interacts with the view, it is drawn into a smaller off-screen target and upscaled (bilinear blit)
+/// to the viewport. The scale is chosen from the measured cost of the view (GPU timer queries, read back without
+/// stalling) so that interactive frames fit in target_ms.
+/// Once the view is still, it is refined progressively: every idle frame renders the view with a different sub-pixel
+/// offset and adds it to a running average in an RGBA16F accumulation buffer. After max_samples frames the image has
+/// converged and the view is no longer drawn at all; the accumulated image is simply presented until something changes.
+/// </summary>
+class glAdaptiveView {
+    enum Mode { DIRECT, REDUCED, REFINE, CONVERGED };
+
+    glFramebuffer target;                               // view rendered off-screen (reduced resolution or refinement frame)
+    glFramebuffer accumulation;                         // running average of the refinement frames
+    GLuint vao = 0;                                     // empty vertex array for the full-screen triangle
+    glProgram* shader = nullptr;                        // copies the refinement frame into the accumulation buffer
+    int samples = 0;                                    // refinement frames averaged in the accumulation buffer
+    glm::vec2 jitter = glm::vec2(0.0f);                 // sub-pixel offset of the current frame (pixels)
+
+    GLuint query = 0;                                   // GL_TIME_ELAPSED query around the view
+    bool query_pending = false;                         // the query has been issued but its result not read yet
+    bool timing = false;                                // a query was started by Begin()
+    float query_scale = 1.0f;                           // scale of the frame measured by the pending query
+    float full_ms = 0.0f;                               // estimated cost of the view at full resolution (0 = unknown)
+
+    Mode mode = DIRECT;
+    float scale = 1.0f;                                 // scale of the current frame
+    int x = 0, y = 0, w = 0, h = 0;                     // viewport of the current frame
+
+    void ReadQuery();
+    bool InitAccumulation();
+    void Accumulate();
+    void Present(const glFramebuffer& source);          // blit a render target into the viewport
+
+public:
+    bool enable = true;                                 // reduce the resolution while interacting
+    float target_ms = 10.0f;                            // budget for the view while interacting
+    float min_scale = 0.25f;                            // lowest resolution scale (per axis)
+    bool progressive = true;                            // refine the view over idle frames
+    int max_samples = 16;                               // refinement frames averaged before the view is converged
+
+    /// <summary>
+    /// Start rendering the view into the viewport (vx, vy, vw, vh). Binds and clears the off-screen target if the
+    /// frame is reduced or refined, otherwise sets the viewport.
+    /// </summary>
+    /// <param name="interacting">The view is being moved (reduce the resolution if it is too slow)</param>
+    /// <param name="changed">Anything drawn in the view changed since the last frame (restarts the refinement)</param>
+    /// <returns>false if the view has converged and does not have to be drawn (End() must still be called)</returns>
+    bool Begin(int vx, int vy, int vw, int vh, bool interacting, bool changed);
+
+    /// <summary>
+    /// Finish the view started by Begin(): upscales a reduced frame, or accumulates a refinement frame, into the viewport
+    /// </summary>
+    void End();
+
+    /// <summary>
+    /// Projection offset for the current frame (premultiply the projection matrix with it)
+    /// </summary>
+    glm::mat4 Jitter() const;
+
+    void Restart() { samples = 0; }                     // discard the accumulated image (ex. when the data changes)
+    float Scale() const { return scale; }               // resolution scale of the last frame (1 = full resolution)
+    float FullResMs() const { return full_ms; }
+    int Samples() const { return samples; }
+    size_t Bytes() const { return target.Bytes() + accumulation.Bytes(); }     // GPU memory of the off-screen targets
+    bool Converged() const { return mode == CONVERGED; }
+    void Destroy();                                     // release the GL objects (requires a current context)
+};
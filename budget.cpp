@@ -0,0 +1,74 @@
+#include "budget.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <iostream>
+
+void MemoryBudget::Set(std::string name, size_t gpu, size_t host, std::function<void()> evict) {
+    for (MemoryEntry& e : entries) {
+        if (e.name == name) {
+            e.gpu = gpu;
+            e.host = host;
+            e.evict = evict;
+            return;
+        }
+    }
+    entries.push_back({ name, gpu, host, evict });
+}
+
+size_t MemoryBudget::Gpu(std::string except) const {
+    size_t total = 0;
+    for (const MemoryEntry& e : entries)
+        if (e.name != except) total += e.gpu;
+    return total;
+}
+
+size_t MemoryBudget::Host(std::string except) const {
+    size_t total = 0;
+    for (const MemoryEntry& e : entries)
+        if (e.name != except) total += e.host;
+    return total;
+}
+
+size_t MemoryBudget::HostAvailable(std::string except) const {
+    size_t used = Host(except);
+    return (used < host_limit) ? host_limit - used : 0;
+}
+
+bool MemoryBudget::Fits(size_t gpu, size_t host, std::string replacing) const {
+    return Gpu(replacing) + gpu <= gpu_limit && Host(replacing) + host <= host_limit;
+}
+
+bool MemoryBudget::Reserve(std::string name, size_t gpu, size_t host) {
+    while (!Fits(gpu, host, name)) {
+        MemoryEntry* largest = nullptr;
+        for (MemoryEntry& e : entries) {
+            if (e.name == name || !e.evict || e.gpu + e.host == 0) continue;
+            if (!largest || e.gpu + e.host > largest->gpu + largest->host) largest = &e;
+        }
+        if (!largest) return false;                     // nothing left to evict
+        std::cout << "Evicting " << largest->name << " (" << (largest->gpu + largest->host) / (1024 * 1024)
+            << " MB) to stay within the memory budget" << std::endl;
+        largest->evict();
+        largest->gpu = largest->host = 0;
+    }
+    return true;
+}
+
+void MemoryBudget::QueryDevice() {
+    GLint kb[4] = { 0, 0, 0, 0 };
+    if (GLEW_NVX_gpu_memory_info) {
+        glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &kb[0]);
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &kb[1]);
+        device_available = (size_t)kb[1] * 1024;
+        if (device_total == 0 && kb[0] > 0) {
+            device_total = (size_t)kb[0] * 1024;
+            gpu_limit = std::min(gpu_limit, device_total / 4 * 3);
+        }
+    }
+    else if (GLEW_ATI_meminfo) {                        // only reports free memory (first value, in KB)
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, kb);
+        device_available = (size_t)kb[0] * 1024;
+    }
+}
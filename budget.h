@@ -0,0 +1,61 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Footprint of one resident resource (ex. the volume texture and its host copy)
+/// </summary>
+struct MemoryEntry {
+    std::string name;
+    size_t gpu = 0;                                     // bytes of GPU memory (textures, buffers)
+    size_t host = 0;                                    // bytes of host memory
+    std::function<void()> evict;                        // releases the resource if it can be rebuilt on demand (optional)
+};
+
+/// <summary>
+/// Hard limits on the GPU and host memory used by the viewer. Every resident resource reports its footprint with
+/// Set(); before a large allocation (ex. loading a volume) Reserve() checks that it fits, evicting resources that
+/// can be rebuilt (caches) if needed. The caller degrades gracefully when it does not fit, for example by loading
+/// a downsampled volume, rather than letting the driver fail or the system swap.
+/// </summary>
+class MemoryBudget {
+    std::vector<MemoryEntry> entries;
+
+public:
+    size_t gpu_limit = (size_t)4 << 30;
+    size_t host_limit = (size_t)8 << 30;
+    size_t device_total = 0;                            // GPU memory reported by the driver (0 = unknown)
+    size_t device_available = 0;                        // GPU memory currently available according to the driver
+
+    /// <summary>
+    /// Record the footprint of a resource (replaces the previous footprint with the same name)
+    /// </summary>
+    /// <param name="evict">Releases the resource when memory is needed (only for resources that are rebuilt on demand)</param>
+    void Set(std::string name, size_t gpu, size_t host, std::function<void()> evict = nullptr);
+
+    size_t Gpu(std::string except = "") const;          // total GPU footprint (optionally without one resource)
+    size_t Host(std::string except = "") const;
+    size_t HostAvailable(std::string except = "") const;    // host memory left within the limit
+    const std::vector<MemoryEntry>& Entries() const { return entries; }
+
+    /// <summary>
+    /// Returns true if a resource of this size fits within both limits
+    /// </summary>
+    /// <param name="replacing">Resource that the new one replaces (its current footprint is not counted)</param>
+    bool Fits(size_t gpu, size_t host, std::string replacing = "") const;
+
+    /// <summary>
+    /// Make room for a resource, evicting rebuildable resources (largest first) until it fits
+    /// </summary>
+    /// <param name="name">Resource being allocated (its current footprint is not counted)</param>
+    /// <returns>false if the resource does not fit even after eviction</returns>
+    bool Reserve(std::string name, size_t gpu, size_t host);
+
+    /// <summary>
+    /// Query the GPU memory of the device (GL_NVX_gpu_memory_info or GL_ATI_meminfo). The first query also lowers
+    /// the GPU limit to 3/4 of the device memory, so the viewer leaves room for other processes on the device.
+    /// </summary>
+    void QueryDevice();                                 // requires a current context
+};
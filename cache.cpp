@@ -0,0 +1,89 @@
+#include "cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+static std::filesystem::path CacheRoot() {
+    std::error_code ec;
+    std::filesystem::path tmp = std::filesystem::temp_directory_path(ec);
+    if (ec) tmp = ".";
+    return tmp / "glOrthoView";
+}
+
+std::string CacheDirectory(std::string category) {
+    std::error_code ec;
+    std::filesystem::path dir = CacheRoot() / category;
+    std::filesystem::create_directories(dir, ec);
+    return dir.string();
+}
+
+unsigned long long CacheHash(const std::string& key) {
+    unsigned long long hash = 14695981039346656037ull;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string CacheFilename(std::string source, std::string category, std::string variant, std::string extension) {
+    std::error_code ec;
+    std::filesystem::path path = std::filesystem::absolute(source, ec);
+    if (ec) return "";
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec) return "";
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return "";
+
+    std::string key = path.string() + "|" + std::to_string(size) + "|" +
+        std::to_string((long long)mtime.time_since_epoch().count()) + "|" + variant;
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", CacheHash(key));
+    return (std::filesystem::path(CacheDirectory(category)) / (name + extension)).string();
+}
+
+void TouchCacheFile(std::string filename) {
+    std::error_code ec;
+    std::filesystem::last_write_time(filename, std::filesystem::file_time_type::clock::now(), ec);
+}
+
+void TrimCache(std::string category, uintmax_t max_bytes, std::string keep) {
+    struct Entry {
+        std::filesystem::path path;
+        uintmax_t size;
+        std::filesystem::file_time_type used;
+    };
+    std::error_code ec;
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    for (const auto& file : std::filesystem::directory_iterator(CacheDirectory(category), ec)) {
+        if (!file.is_regular_file(ec) || file.path().extension() == ".tmp") continue;
+        Entry e = { file.path(), file.file_size(ec), file.last_write_time(ec) };
+        if (ec) continue;
+        total += e.size;
+        entries.push_back(e);
+    }
+    if (total <= max_bytes) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    size_t removed = 0;
+    for (const Entry& e : entries) {
+        if (total <= max_bytes) break;
+        if (!keep.empty() && std::filesystem::equivalent(e.path, keep, ec)) continue;
+        if (std::filesystem::remove(e.path, ec)) {
+            total -= e.size;
+            removed++;
+        }
+    }
+    if (removed > 0) std::cout << "Removed " << removed << " least recently used files from the " << category << " cache" << std::endl;
+}
+
+void PurgeCache() {
+    std::error_code ec;
+    uintmax_t removed = std::filesystem::remove_all(CacheRoot(), ec);
+    if (ec) std::cout << "ERROR: unable to delete the cache in " << CacheRoot().string() << std::endl;
+    else std::cout << "Deleted " << removed << " cached files from " << CacheRoot().string() << std::endl;
+}
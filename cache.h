@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#define CACHE_LIMIT_DOWNSAMPLED ((uintmax_t)2 << 30)    // downsampled volumes (quick look and session previews)
+#define CACHE_LIMIT_THUMBNAILS ((uintmax_t)64 << 20)    // file dialog thumbnails
+#define CACHE_LIMIT_SHADERS ((uintmax_t)16 << 20)       // linked program binaries (a new set per shader edit or driver update)
+
+/// <summary>
+/// Directory of an on-disk cache category (ex. "thumbnails") in the system temporary directory. The directory is
+/// created if it does not exist.
+/// </summary>
+std::string CacheDirectory(std::string category);
+
+/// <summary>
+/// File name of a cached result derived from a source file. The name is a hash of the absolute path, size and
+/// modification time of the source and of the variant (the parameters of the result), so a modified source never
+/// matches an old entry.
+/// </summary>
+/// <param name="variant">Parameters of the cached result (ex. "h32")</param>
+/// <returns>an empty string if the source does not exist</returns>
+std::string CacheFilename(std::string source, std::string category, std::string variant, std::string extension = ".npy");
+
+/// <summary>
+/// FNV-1a hash of a string, used for cache keys
+/// </summary>
+unsigned long long CacheHash(const std::string& key);
+
+/// <summary>
+/// Mark a cache entry as used (its modification time orders the entries for TrimCache)
+/// </summary>
+void TouchCacheFile(std::string filename);
+
+/// <summary>
+/// Delete the least recently used entries of a cache category until its total size is at most max_bytes. Files
+/// that are still being written (*.tmp) are left alone.
+/// </summary>
+/// <param name="keep">Entry that is never deleted (ex. the one that was just written and is about to be loaded)</param>
+void TrimCache(std::string category, uintmax_t max_bytes, std::string keep = "");
+
+/// <summary>
+/// Delete every cached file of the viewer (all categories)
+/// </summary>
+void PurgeCache();
@@ -0,0 +1,125 @@
+#include "capture.h"
+
+#include "framebuffer.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+glCapture::glCapture(Sink s, int ring_size, bool asynchronous) : async(asynchronous), sink(s) {
+    if (async && !GLEW_ARB_sync) {                      // fences require OpenGL 3.2 or ARB_sync
+        std::cout << "WARNING: ARB_sync is not available, falling back to synchronous readback" << std::endl;
+        async = false;
+    }
+    if (ring_size < 1) ring_size = 1;
+    ring.resize(ring_size);
+    if (async) {
+        for (Slot& slot : ring)
+            glGenBuffers(1, &slot.pbo);
+    }
+}
+
+glCapture::~glCapture() {
+    Flush();
+    for (Slot& slot : ring)
+        if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+}
+
+void glCapture::Complete(Slot& s) {
+    glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(s.fence);
+    s.fence = 0;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+        (size_t)s.width * s.height * 4, GL_MAP_READ_BIT);
+    if (pixels) {                                       // a failed map leaves nothing to unmap
+        sink(s.tag, pixels, s.width, s.height);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+        std::cout << "WARNING: failed to map the readback buffer, capture " << s.tag << " was dropped" << std::endl;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void glCapture::Capture(int x, int y, int width, int height, int tag) {
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    size_t bytes = (size_t)width * height * 4;
+
+    if (!async) {
+        host.resize(bytes);
+        glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, host.data());
+        sink(tag, host.data(), width, height);
+        return;
+    }
+
+    if (pending == ring.size()) {                       // the ring is full: retire the oldest capture
+        Complete(ring[head]);
+        head = (head + 1) % ring.size();
+        pending--;
+    }
+
+    Slot& s = ring[(head + pending) % ring.size()];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    if (s.bytes < bytes) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+        s.bytes = bytes;
+    }
+    glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);   // returns immediately, the copy happens on the GPU
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    s.width = width;
+    s.height = height;
+    s.tag = tag;
+    pending++;
+}
+
+size_t glCapture::Poll() {
+    size_t delivered = 0;
+    while (pending > 0) {
+        Slot& s = ring[head];
+        GLenum status = glClientWaitSync(s.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        Complete(s);
+        head = (head + 1) % ring.size();
+        pending--;
+        delivered++;
+    }
+    return delivered;
+}
+
+void glCapture::Flush() {
+    while (pending > 0) {
+        Complete(ring[head]);
+        head = (head + 1) % ring.size();
+        pending--;
+    }
+}
+
+double BenchmarkReadback(std::function<void(int width, int height)> render, int width, int height, int frames, bool asynchronous) {
+    glFramebuffer target;
+    if (!target.Resize(width, height)) return 0.0;
+
+    std::vector<unsigned char> copy((size_t)width * height * 4);
+    glCapture capture([&](int, const unsigned char* rgba, int w, int h) {
+        memcpy(copy.data(), rgba, (size_t)w * h * 4);  // touch the pixels the way a consumer would
+    }, 3, asynchronous);
+
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    target.Bind();
+    for (int i = 0; i < frames; i++) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        render(width, height);
+        capture.Capture(0, 0, width, height, i);
+        capture.Poll();
+    }
+    capture.Flush();
+    target.Unbind();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double fps = frames / seconds;
+    std::cout << (capture.Asynchronous() ? "async" : "sync ") << " readback: " << frames << " frames (" << width << "x" << height
+        << ") in " << seconds << " s, " << fps << " fps, " << fps * width * height * 4 / (1024.0 * 1024.0) << " MB/s" << std::endl;
+    return fps;
+}
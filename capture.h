@@ -0,0 +1,72 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <functional>
+#include <vector>
+
+/// <summary>
+/// Reads back rendered images from the GPU. In asynchronous mode glReadPixels targets a ring of pixel buffer
+/// objects and a fence is inserted after each read, so frame N is transferred while frame N+1 is rendered.
+/// Completed captures are handed to the sink (on the calling thread) in the order they were requested.
+/// In synchronous mode every Capture() stalls until the pixels are available (used as a fallback and for benchmarking).
+/// </summary>
+class glCapture {
+public:
+    /// receives the RGBA8 pixels (bottom-up rows) of a completed capture; the pointer is only valid during the call
+    typedef std::function<void(int tag, const unsigned char* rgba, int width, int height)> Sink;
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = 0;
+        size_t bytes = 0;                               // allocated size of the PBO
+        int width = 0;
+        int height = 0;
+        int tag = 0;
+    };
+    std::vector<Slot> ring;
+    size_t head = 0;                                    // oldest pending slot
+    size_t pending = 0;                                 // number of captures in flight
+    bool async;
+    Sink sink;
+    std::vector<unsigned char> host;                    // staging buffer for synchronous reads
+
+    void Complete(Slot& s);
+
+public:
+    /// <param name="sink">Function called with the pixels of each completed capture</param>
+    /// <param name="ring_size">Number of PBOs (captures that can be in flight at once)</param>
+    /// <param name="asynchronous">Use PBOs and fences (true) or a blocking glReadPixels (false)</param>
+    glCapture(Sink sink, int ring_size = 3, bool asynchronous = true);
+    ~glCapture();
+    glCapture(const glCapture&) = delete;
+    glCapture& operator=(const glCapture&) = delete;
+
+    /// <summary>
+    /// Queue a read of a rectangle of the currently bound read framebuffer. If the ring is full the oldest
+    /// capture is completed first (blocking only if the GPU has not finished it yet).
+    /// </summary>
+    void Capture(int x, int y, int width, int height, int tag = 0);
+
+    /// <summary>
+    /// Deliver every capture whose fence has already signaled without blocking. Returns the number delivered.
+    /// </summary>
+    size_t Poll();
+
+    /// <summary>
+    /// Block until all pending captures have been delivered
+    /// </summary>
+    void Flush();
+
+    size_t Pending() const { return pending; }
+    bool Asynchronous() const { return async; }
+};
+
+/// <summary>
+/// Measure readback throughput by rendering and capturing a number of off-screen frames
+/// </summary>
+/// <param name="render">Renders a frame into the currently bound framebuffer of size (width, height)</param>
+/// <param name="asynchronous">Use the PBO ring (true) or blocking glReadPixels (false)</param>
+/// <returns>Frames per second, including rendering</returns>
+double BenchmarkReadback(std::function<void(int width, int height)> render, int width, int height, int frames, bool asynchronous);
@@ -0,0 +1,137 @@
+#include "crop.h"
+#include "npy.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#define CROP_ALIGN 4096                                 // source reads start and end on multiples of this many bytes
+#define CROP_SLAB_BYTES (32 << 20)                      // approximate size of one source read
+
+/// <summary>
+/// Returns a pointer to bytes [offset, offset + length) of the source array, using buffer as storage if needed
+/// </summary>
+typedef std::function<const unsigned char*(size_t offset, size_t length, std::vector<unsigned char>& buffer)> SlabReader;
+
+/// <summary>
+/// Shared implementation: walks the source in z order one slab at a time and hands each slab to a worker thread
+/// that gathers the cropped rows and writes them to their (contiguous) location in the destination
+/// </summary>
+static bool WriteSubvolume(size_t X, size_t Y, size_t Z, size_t voxel_bytes, glm::ivec3 lo, glm::ivec3 hi,
+    std::string destination, const std::string& header, SlabReader read) {
+
+    lo = glm::max(glm::min(lo, hi), glm::ivec3(0));
+    hi = glm::min(glm::max(lo, hi), glm::ivec3((int)X - 1, (int)Y - 1, (int)Z - 1));
+    if (lo.x > hi.x || lo.y > hi.y || lo.z > hi.z) return false;
+    size_t nx = hi.x - lo.x + 1, ny = hi.y - lo.y + 1, nz = hi.z - lo.z + 1;
+    size_t row_bytes = X * voxel_bytes;
+    size_t out_row = nx * voxel_bytes;
+
+    {
+        std::ofstream out(destination, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cout << "ERROR: unable to create " << destination << std::endl;
+            return false;
+        }
+        out.write(header.data(), header.size());
+    }
+
+    // a slab is a run of slices read in one request: reading the rows between the cropped region of two slices
+    // is only worth it if they are smaller than the region itself
+    size_t span = ny * row_bytes;                       // bytes read for one slice
+    size_t gap = (Y - ny) * row_bytes;                  // bytes skipped between slices
+    size_t slab_slices = (gap > span) ? 1 : std::max<size_t>(1, CROP_SLAB_BYTES / (Y * row_bytes));
+
+    WorkerPool writers;
+    std::atomic<bool> ok(true);
+    for (size_t z0 = lo.z; z0 <= (size_t)hi.z && ok; z0 += slab_slices) {
+        size_t z1 = std::min(z0 + slab_slices - 1, (size_t)hi.z);
+        writers.wait_below(2 * writers.size());        // bound the number of slabs held in memory
+
+        auto buffer = std::make_shared<std::vector<unsigned char>>();
+        const unsigned char* src = read((z0 * Y + lo.y) * row_bytes, ((z1 - z0) * Y + ny) * row_bytes, *buffer);
+        if (!src) {
+            std::cout << "ERROR: unable to read slices " << z0 << " - " << z1 << " of the source volume" << std::endl;
+            ok = false;
+            break;
+        }
+
+        writers.submit([=, &ok] {
+            std::vector<unsigned char> slab((z1 - z0 + 1) * ny * out_row);
+            unsigned char* dst = slab.data();
+            for (size_t z = z0; z <= z1; z++) {
+                for (size_t y = 0; y < ny; y++, dst += out_row)
+                    memcpy(dst, src + ((z - z0) * Y + y) * row_bytes + lo.x * voxel_bytes, out_row);
+            }
+
+            std::fstream out(destination, std::ios::binary | std::ios::in | std::ios::out);
+            out.seekp(header.size() + (z0 - lo.z) * ny * out_row);
+            out.write((const char*)slab.data(), slab.size());
+            if (!out) ok = false;
+            (void)buffer;                               // keeps the source slab alive until it has been copied
+        });
+    }
+    writers.wait();
+
+    if (!ok) {
+        std::cout << "ERROR: failed to write " << destination << std::endl;
+        return false;
+    }
+    std::cout << "Saved " << nx << "x" << ny << "x" << nz << " subvolume to " << destination << std::endl;
+    return true;
+}
+
+bool ExportSubvolume(std::string source, std::string destination, glm::ivec3 lo, glm::ivec3 hi, int format) {
+    NpyHeader npy;
+    if (!ReadNpyHeader(source, npy) || (npy.shape.size() != 3 && npy.shape.size() != 4) || npy.fortran_order) {
+        std::cout << "ERROR: " << source << " is not a C-order 3D NumPy array" << std::endl;
+        return false;
+    }
+    size_t C = (npy.shape.size() == 4) ? npy.shape[3] : 1;
+    size_t Z = npy.shape[0], Y = npy.shape[1], X = npy.shape[2];
+
+    std::vector<size_t> shape = npy.shape;
+    glm::ivec3 clo = glm::max(glm::min(lo, hi), glm::ivec3(0));
+    glm::ivec3 chi = glm::min(glm::max(lo, hi), glm::ivec3((int)X - 1, (int)Y - 1, (int)Z - 1));
+    shape[0] = std::max(0, chi.z - clo.z + 1);
+    shape[1] = std::max(0, chi.y - clo.y + 1);
+    shape[2] = std::max(0, chi.x - clo.x + 1);
+    std::string header = (format == CROP_NPY) ? MakeNpyHeader(npy.descr, shape) : std::string();
+
+    std::ifstream in(source, std::ios::binary);
+    in.seekg(0, std::ios::end);
+    size_t file_size = (size_t)in.tellg();
+
+    SlabReader read = [&](size_t offset, size_t length, std::vector<unsigned char>& buffer) -> const unsigned char* {
+        size_t begin = npy.offset + offset;
+        size_t aligned = begin - begin % CROP_ALIGN;    // round the request out to whole chunks
+        size_t end = std::min(file_size, (begin + length + CROP_ALIGN - 1) / CROP_ALIGN * CROP_ALIGN);
+        if (begin + length > file_size) return nullptr;
+        buffer.resize(end - aligned);
+        in.seekg(aligned);
+        in.read((char*)buffer.data(), buffer.size());
+        if (!in) return nullptr;
+        return buffer.data() + (begin - aligned);
+    };
+    return WriteSubvolume(X, Y, Z, C * npy.itemsize, lo, hi, destination, header, read);
+}
+
+bool ExportSubvolume(const VoxelGrid& grid, std::string destination, glm::ivec3 lo, glm::ivec3 hi, int format) {
+    if (!grid.data) return false;
+    glm::ivec3 clo = glm::max(glm::min(lo, hi), glm::ivec3(0));
+    glm::ivec3 chi = glm::min(glm::max(lo, hi), glm::ivec3((int)grid.X - 1, (int)grid.Y - 1, (int)grid.Z - 1));
+    std::vector<size_t> shape = { (size_t)std::max(0, chi.z - clo.z + 1), (size_t)std::max(0, chi.y - clo.y + 1), (size_t)std::max(0, chi.x - clo.x + 1) };
+    if (grid.C > 1) shape.push_back(grid.C);
+    std::string header = (format == CROP_NPY) ? MakeNpyHeader("|u1", shape) : std::string();
+
+    SlabReader read = [&](size_t offset, size_t, std::vector<unsigned char>&) -> const unsigned char* {
+        return grid.data + offset;                      // already resident: no copy
+    };
+    return WriteSubvolume(grid.X, grid.Y, grid.Z, grid.C, lo, hi, destination, header, read);
+}
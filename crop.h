@@ -0,0 +1,21 @@
+#pragma once
+
+#include "reslice.h"
+
+#include <string>
+
+enum CropFormat { CROP_NPY = 0, CROP_RAW };
+
+/// <summary>
+/// Copy the voxels between lo and hi (inclusive, clamped to the volume) of a NumPy file into a new file without
+/// loading the source. The source is read front to back in large chunk-aligned slabs of slices, and each slab is
+/// cropped and written by a pool of worker threads, so neither volume is ever held in memory as a whole. The data
+/// type of the source is preserved; CROP_RAW writes the voxels without a header.
+/// </summary>
+/// <returns>false if the source cannot be read or the destination cannot be written</returns>
+bool ExportSubvolume(std::string source, std::string destination, glm::ivec3 lo, glm::ivec3 hi, int format);
+
+/// <summary>
+/// Export a subvolume of a volume that only exists in memory (ex. the generated default volume) as 8-bit voxels
+/// </summary>
+bool ExportSubvolume(const VoxelGrid& grid, std::string destination, glm::ivec3 lo, glm::ivec3 hi, int format);
@@ -0,0 +1,52 @@
+#include "dataset.h"
+
+#include <cstdio>
+#include <filesystem>
+
+bool ReadDatasetInfo(std::string filename, DatasetInfo& info) {
+    info = DatasetInfo();
+    if (!ReadNpyHeader(filename, info.header)) return false;
+    const std::vector<size_t>& shape = info.header.shape;
+    if (shape.size() != 3 && shape.size() != 4) return false;
+    info.Z = shape[0];
+    info.Y = shape[1];
+    info.X = shape[2];
+    info.C = (shape.size() == 4) ? shape[3] : 1;
+
+    std::error_code ec;
+    info.file_bytes = (size_t)std::filesystem::file_size(filename, ec);
+    info.complete = !ec && info.file_bytes >= info.header.offset + info.header.bytes();
+    LoadVolumeMetadata(filename, info.meta, false);
+    return true;
+}
+
+std::string DatasetTypeName(const NpyHeader& header) {
+    std::string bits = std::to_string(8 * header.itemsize);
+    switch (header.kind) {
+    case 'u': return "uint" + bits;
+    case 'i': return "int" + bits;
+    case 'f': return "float" + bits;
+    case 'b': return "bool";
+    }
+    return header.descr;
+}
+
+std::string FormatBytes(size_t bytes) {
+    const char* units[] = { "B", "KB", "MB", "GB", "TB" };
+    double value = (double)bytes;
+    int u = 0;
+    while (value >= 1024.0 && u < 4) {
+        value /= 1024.0;
+        u++;
+    }
+    char text[32];
+    snprintf(text, sizeof(text), (u == 0) ? "%.0f %s" : "%.1f %s", value, units[u]);
+    return text;
+}
+
+int FitDownsampling(size_t bytes, size_t budget) {
+    for (int factor = 1; factor <= 8; factor *= 2) {
+        if (bytes / ((size_t)factor * factor * factor) <= budget) return factor;
+    }
+    return 0;
+}
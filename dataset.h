@@ -0,0 +1,43 @@
+#pragma once
+
+#include "npy.h"
+#include "metadata.h"
+
+#include <string>
+
+/// <summary>
+/// Description of a volume file gathered without reading its voxels: the NumPy header, the size of the file and
+/// the voxel spacing of its sidecar (if any). Used to preview a dataset before committing to loading it.
+/// </summary>
+struct DatasetInfo {
+    NpyHeader header;
+    size_t X = 0, Y = 0, Z = 0, C = 0;
+    size_t file_bytes = 0;                              // size of the file on disk
+    bool complete = false;                              // the file holds all of the array data (it is not truncated)
+    VolumeMetadata meta;                                // spacing read from a sidecar (defaults if there is none)
+
+    size_t voxels() const { return X * Y * Z; }
+    size_t texture_bytes() const { return voxels() * C; }    // volumes are resident as 8-bit textures
+};
+
+/// <summary>
+/// Read the header of a NumPy volume (Z, Y, X) or (Z, Y, X, C) and its sidecar. Only the header is read.
+/// </summary>
+/// <returns>false if the file is not a NumPy array with 3 or 4 dimensions</returns>
+bool ReadDatasetInfo(std::string filename, DatasetInfo& info);
+
+/// <summary>
+/// Name of the NumPy data type of an array (ex. "uint16")
+/// </summary>
+std::string DatasetTypeName(const NpyHeader& header);
+
+/// <summary>
+/// Human readable size (ex. "1.5 GB")
+/// </summary>
+std::string FormatBytes(size_t bytes);
+
+/// <summary>
+/// Smallest downsampling factor (1, 2, 4 or 8 along every axis) that brings a volume of the given size within the
+/// budget, or 0 if even 8x downsampling does not fit
+/// </summary>
+int FitDownsampling(size_t bytes, size_t budget);
@@ -0,0 +1,54 @@
+#include "demo.h"
+#include "parallel.h"
+#include "startup.h"
+
+#include <chrono>
+#include <iostream>
+
+unsigned char DemoVolume::Value(size_t x, size_t y, size_t z, size_t c) {
+    size_t p[3] = { x, y, z };
+    unsigned int v = (unsigned int)(p[c] * 255 / (DEMO_SIZE - 1));
+    bool line = (x % DEMO_GRID == 0) || (y % DEMO_GRID == 0) || (z % DEMO_GRID == 0);
+    return (unsigned char)(line ? v / 2 : v);
+}
+
+void DemoVolume::Generate() {
+    if (!voxels.empty()) return;
+    auto start = std::chrono::steady_clock::now();
+    voxels.resize(X * Y * Z * C);
+    parallel_for(Z, [&](size_t begin, size_t end) {
+        for (size_t z = begin; z < end; z++) {
+            unsigned char* slice = &voxels[z * Y * X * C];
+            for (size_t y = 0; y < Y; y++) {
+                for (size_t x = 0; x < X; x++) {
+                    for (size_t c = 0; c < C; c++)
+                        slice[(y * X + x) * C + c] = Value(x, y, z, c);
+                }
+            }
+        }
+    });
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB8, (GLsizei)X, (GLsizei)Y, (GLsizei)Z, 0, GL_RGB, GL_UNSIGNED_BYTE, voxels.data());
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    trace.Timing("generated the " + std::to_string(X) + "x" + std::to_string(Y) + "x" + std::to_string(Z) + " demo volume", start);
+}
+
+void DemoVolume::Release() {
+    if (texture) glDeleteTextures(1, &texture);
+    texture = 0;
+    std::vector<unsigned char>().swap(voxels);
+}
+
+void DemoVolume::Bind() {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_3D, texture);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "tira/graphics_gl.h"
+
+#include <vector>
+
+#define DEMO_SIZE 256                                   // voxels along each axis of the demo volume
+#define DEMO_GRID 32                                    // spacing of its grid lines in voxels
+
+/// <summary>
+/// Placeholder volume shown when no file is loaded: an RGB color cube (the color of a voxel is its position) with
+/// darker grid lines every DEMO_GRID voxels. The slices are computed in the slicer shader (demo_color), so showing
+/// the demo costs no memory and no work at startup. The voxels are only generated, in parallel, when a CPU tool
+/// needs them (ex. ROI statistics or the isosurface); they are uploaded at the same time for the shaders that
+/// sample the volume texture.
+/// </summary>
+class DemoVolume {
+    std::vector<unsigned char> voxels;
+    GLuint texture = 0;
+
+public:
+    static constexpr size_t X = DEMO_SIZE, Y = DEMO_SIZE, Z = DEMO_SIZE, C = 3;
+
+    /// <summary>
+    /// Value of one channel of a voxel, computed without generating the volume (same as demo_color in the shader)
+    /// </summary>
+    static unsigned char Value(size_t x, size_t y, size_t z, size_t c);
+
+    /// <summary>
+    /// Generate the voxels and upload them as a texture (once)
+    /// </summary>
+    void Generate();
+    void Release();
+
+    const unsigned char* Data() const { return voxels.empty() ? nullptr : voxels.data(); }   // null until generated
+    size_t HostBytes() const { return voxels.size(); }
+    size_t GpuBytes() const { return texture ? voxels.size() : 0; }
+
+    /// <summary>
+    /// Bind the texture (if generated) to texture unit 0
+    /// </summary>
+    void Bind();
+};
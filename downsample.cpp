@@ -0,0 +1,220 @@
+#include "downsample.h"
+#include "npy.h"
+#include "cache.h"
+#include "parallel.h"
+#include "reslice.h"
+#include "startup.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DOWNSAMPLE_SSE
+#endif
+
+void AccumulateRow(float* acc, const float* row, size_t n) {
+    size_t i = 0;
+#ifdef DOWNSAMPLE_SSE
+    for (; i + 8 <= n; i += 8) {
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(row + i)));
+        _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_loadu_ps(row + i + 4)));
+    }
+#endif
+    for (; i < n; i++)
+        acc[i] += row[i];
+}
+
+/// <summary>
+/// Reduce a slab of nz source slices into one output slice: the rows covered by an output row are summed over the
+/// slab (vertical and depth box filter), then groups of f voxels are summed along x and divided by their count
+/// </summary>
+static void ReduceSlab(const NpyHeader& header, const unsigned char* slab, size_t nz, size_t X, size_t Y, size_t C,
+    size_t f, float* dst) {
+
+    size_t row_values = X * C;
+    size_t row_bytes = row_values * header.itemsize;
+    size_t Xo = (X + f - 1) / f;
+    size_t Yo = (Y + f - 1) / f;
+    std::vector<float> row(row_values), acc(row_values);
+
+    for (size_t oy = 0; oy < Yo; oy++) {
+        size_t ny = std::min(f, Y - oy * f);
+        std::fill(acc.begin(), acc.end(), 0.0f);
+        for (size_t z = 0; z < nz; z++) {
+            for (size_t k = 0; k < ny; k++) {
+                NpyToFloat(header, slab + (z * Y + oy * f + k) * row_bytes, row_values, row.data());
+                AccumulateRow(acc.data(), row.data(), row_values);
+            }
+        }
+
+        float* out = dst + oy * Xo * C;
+        for (size_t ox = 0; ox < Xo; ox++) {
+            size_t nx = std::min(f, X - ox * f);
+            float weight = 1.0f / (float)(nz * ny * nx);
+            for (size_t c = 0; c < C; c++) {
+                float sum = 0.0f;
+                for (size_t k = 0; k < nx; k++)
+                    sum += acc[(ox * f + k) * C + c];
+                out[ox * C + c] = sum * weight;
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Quantize a reduced volume to 8 bits and write it as a NumPy file with the shape of the source (3D or 4D)
+/// </summary>
+static bool WriteReduced(const NpyHeader& header, const std::vector<float>& reduced, std::vector<size_t> shape, size_t C,
+    std::string destination) {
+
+    // quantize to 8 bits
+    float lo = 0.0f, hi = 255.0f;
+    if (header.itemsize != 1 || header.kind == 'i') {
+        auto range = std::minmax_element(reduced.begin(), reduced.end());
+        lo = *range.first;
+        hi = *range.second;
+    }
+    float scale = (hi > lo) ? 255.0f / (hi - lo) : 0.0f;
+    std::vector<unsigned char> voxels(reduced.size());
+    parallel_for(reduced.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            voxels[i] = (unsigned char)std::clamp((reduced[i] - lo) * scale + 0.5f, 0.0f, 255.0f);
+    }, 1 << 20);
+
+    if (header.shape.size() == 4) shape.push_back(C);
+    std::string tmp = destination + ".tmp";             // renamed when complete, so a partial file is never loaded
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        std::string npy = MakeNpyHeader("|u1", shape);
+        out.write(npy.data(), npy.size());
+        out.write((const char*)voxels.data(), voxels.size());
+        if (!out) {
+            std::cout << "ERROR: unable to write " << tmp << std::endl;
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, destination, ec);
+    if (ec) {
+        std::cout << "ERROR: unable to write " << destination << std::endl;
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool DownsampleNpy(std::string source, std::string destination, int factor, size_t host_budget) {
+    NpyHeader header;
+    if (!ReadNpyHeader(source, header)) {
+        std::cout << "ERROR: unable to read the NumPy header of " << source << std::endl;
+        return false;
+    }
+    float probe;                                        // converting 0 values only checks that the type is supported
+    if (header.fortran_order || (header.shape.size() != 3 && header.shape.size() != 4) ||
+        !NpyToFloat(header, &probe, 0, &probe) || factor < 1) {
+        std::cout << "ERROR: " << source << " cannot be downsampled (requires a C-order volume with a numeric type)" << std::endl;
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    size_t Z = header.shape[0], Y = header.shape[1], X = header.shape[2];
+    size_t C = (header.shape.size() == 4) ? header.shape[3] : 1;
+    size_t f = (size_t)factor;
+    size_t Xo = (X + f - 1) / f, Yo = (Y + f - 1) / f, Zo = (Z + f - 1) / f;
+    size_t slice_bytes = Y * X * C * header.itemsize;
+    std::vector<float> reduced(Zo * Yo * Xo * C);
+
+    // the slabs held in memory (read or being reduced) are limited by the budget left once the reduced volume is
+    // allocated: at least one slab, and no more than the workers can keep busy
+    size_t reduced_bytes = reduced.size() * sizeof(float);
+    size_t slab_bytes = std::max<size_t>(1, f * slice_bytes);
+    size_t max_slabs = (host_budget > reduced_bytes) ? (host_budget - reduced_bytes) / slab_bytes : 0;
+
+    // read slabs in order (sequential I/O) and reduce them in parallel
+    std::ifstream in(source, std::ios::binary);
+    in.seekg(header.offset);
+    bool ok = true;
+    {
+        WorkerPool reducers;
+        max_slabs = std::clamp<size_t>(max_slabs, 1, 2 * reducers.size());
+        for (size_t oz = 0; oz < Zo; oz++) {
+            size_t nz = std::min(f, Z - oz * f);
+            reducers.wait_below(max_slabs);             // the next slab is read once fewer than max_slabs are held
+
+            auto slab = std::make_shared<std::vector<unsigned char>>(nz * slice_bytes);
+            in.read((char*)slab->data(), slab->size());
+            if (!in) {
+                std::cout << "ERROR: unable to read slices " << oz * f << " - " << oz * f + nz - 1 << " of " << source << std::endl;
+                ok = false;
+                break;
+            }
+            float* dst = &reduced[oz * Yo * Xo * C];
+            reducers.submit([=, &header] { ReduceSlab(header, slab->data(), nz, X, Y, C, f, dst); });
+        }
+        reducers.wait();
+    }
+    if (!ok) return false;
+
+    if (!WriteReduced(header, reduced, { Zo, Yo, Xo }, C, destination)) return false;
+
+    trace.Timing("downsampled " + std::to_string(X) + "x" + std::to_string(Y) + "x" + std::to_string(Z) + " to " +
+        std::to_string(Xo) + "x" + std::to_string(Yo) + "x" + std::to_string(Zo) + " (" + std::to_string(factor) + "x)", start);
+    return true;
+}
+
+std::string DownsampledVolume(std::string source, int factor, size_t host_budget) {
+    std::string cached = CacheFilename(source, "downsampled", "f" + std::to_string(factor));
+    if (cached.empty()) {
+        std::cout << "ERROR: unable to open " << source << std::endl;
+        return "";
+    }
+    std::error_code ec;
+    if (std::filesystem::exists(cached, ec)) {
+        TouchCacheFile(cached);
+        return cached;
+    }
+    if (!DownsampleNpy(source, cached, factor, host_budget)) return "";
+    TrimCache("downsampled", CACHE_LIMIT_DOWNSAMPLED, cached);
+    return cached;
+}
+
+std::string CachedDownsampledVolume(std::string source, int factor) {
+    std::string cached = CacheFilename(source, "downsampled", "f" + std::to_string(factor));
+    std::error_code ec;
+    if (cached.empty() || !std::filesystem::exists(cached, ec)) return "";
+    TouchCacheFile(cached);
+    return cached;
+}
+
+bool CacheDownsampledGrid(const VoxelGrid& grid, std::string source, int factor) {
+    NpyHeader header;
+    if (!ReadNpyHeader(source, header) || header.descr != "|u1") return false;
+    if (header.count() != grid.X * grid.Y * grid.Z * grid.C || factor < 2) return false;
+    std::string cached = CacheFilename(source, "downsampled", "f" + std::to_string(factor));
+    if (cached.empty()) return false;
+    std::error_code ec;
+    if (std::filesystem::exists(cached, ec)) {
+        TouchCacheFile(cached);
+        return true;
+    }
+
+    size_t f = (size_t)factor;
+    size_t Xo = (grid.X + f - 1) / f, Yo = (grid.Y + f - 1) / f, Zo = (grid.Z + f - 1) / f;
+    size_t slice_bytes = grid.Y * grid.X * grid.C;
+    std::vector<float> reduced(Zo * Yo * Xo * grid.C);
+    parallel_for(Zo, [&](size_t begin, size_t end) {
+        for (size_t oz = begin; oz < end; oz++) {
+            size_t nz = std::min(f, grid.Z - oz * f);
+            ReduceSlab(header, grid.data + oz * f * slice_bytes, nz, grid.X, grid.Y, grid.C, f, &reduced[oz * Yo * Xo * grid.C]);
+        }
+    });
+    if (!WriteReduced(header, reduced, { Zo, Yo, Xo }, grid.C, cached)) return false;
+    TrimCache("downsampled", CACHE_LIMIT_DOWNSAMPLED, cached);
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+struct VoxelGrid;
+
+/// <summary>
+/// acc[i] += row[i] for n values (SSE2 when available). Building block of the box filters that reduce volumes.
+/// </summary>
+void AccumulateRow(float* acc, const float* row, size_t n);
+
+/// <summary>
+/// Write a copy of a NumPy volume (Z, Y, X) or (Z, Y, X, C) reduced by factor along every axis. The source is
+/// streamed front to back one slab of factor slices at a time and each slab is reduced by a worker thread as soon
+/// as it has been read, so the source is never resident: memory and output scale with the reduced volume. Every
+/// output voxel is the mean (box filter) of the source voxels it covers. The result is an 8-bit NumPy file (the
+/// type of the viewer's volumes): 8-bit sources keep their values, other types are stretched to the range of the
+/// reduced volume.
+/// </summary>
+/// <param name="factor">Reduction along every axis (ex. 2 keeps one voxel out of 8)</param>
+/// <param name="host_budget">Host memory available for the reduced volume and the slabs in flight (at least one slab
+/// is read at a time)</param>
+/// <returns>false if the source cannot be read or the destination cannot be written</returns>
+bool DownsampleNpy(std::string source, std::string destination, int factor, size_t host_budget);
+
+/// <summary>
+/// Path of the downsampled copy of a volume. Copies are kept in an on-disk cache, so only the first quick look at
+/// a volume reads the full-resolution file. The cache is limited to CACHE_LIMIT_DOWNSAMPLED bytes: the least
+/// recently used copies are deleted after each new copy is written.
+/// </summary>
+/// <param name="host_budget">Host memory available to build a new copy (see DownsampleNpy)</param>
+/// <returns>an empty string if the volume cannot be downsampled</returns>
+std::string DownsampledVolume(std::string source, int factor, size_t host_budget);
+
+/// <summary>
+/// Path of the cached downsampled copy of a volume if it has already been built (never reads the volume)
+/// </summary>
+/// <returns>an empty string if there is no cached copy</returns>
+std::string CachedDownsampledVolume(std::string source, int factor);
+
+/// <summary>
+/// Build the cached downsampled copy of an 8-bit volume from its resident voxels rather than from the file, so the
+/// next quick look at the volume (or restoring a session) starts from the cache without reading the full file.
+/// Only 8-bit sources are handled, since their voxels are resident unchanged.
+/// </summary>
+/// <param name="source">File the grid was loaded from (the key of the cache)</param>
+/// <returns>true if the copy exists when the function returns</returns>
+bool CacheDownsampledGrid(const VoxelGrid& grid, std::string source, int factor);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+/// <summary>
+/// Off-screen render target (color texture + depth renderbuffer) used to render views at a resolution that is
+/// independent of the window, for example when exporting images. The color texture is RGBA8 unless another
+/// format is requested (ex. GL_RGBA16F for accumulation).
+/// </summary>
+class glFramebuffer {
+    GLuint fbo = 0;
+    GLuint color = 0;                                   // color texture
+    GLuint depth = 0;                                   // depth renderbuffer
+    int width = 0;
+    int height = 0;
+    GLenum format = GL_RGBA8;                           // internal format of the color texture
+    GLint previous = 0;                                 // framebuffer that was bound before Bind() was called
+
+public:
+    glFramebuffer() {}
+    ~glFramebuffer() { Destroy(); }
+    glFramebuffer(const glFramebuffer&) = delete;
+    glFramebuffer& operator=(const glFramebuffer&) = delete;
+
+    /// <summary>
+    /// Allocate (or re-allocate if the size or format changed) the render target. Returns false if the framebuffer is incomplete.
+    /// </summary>
+    bool Resize(int w, int h, GLenum color_format = GL_RGBA8);
+    void Destroy();
+
+    void Bind();                                        // render into this target (sets the viewport to cover it)
+    void Unbind();                                      // restore the previously bound framebuffer
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    GLuint ID() const { return fbo; }
+    GLuint ColorTexture() const { return color; }
+    size_t Bytes() const {                              // GPU memory of the color texture and depth buffer
+        return (size_t)width * height * (((format == GL_RGBA16F) ? 8 : 4) + 4);
+    }
+};
@@ -7,27 +7,106 @@
 
 
 
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <stdio.h>
 #include "gui.h"
-
-
+#include "sweep.h"
+#include "capture.h"
+#include "imagewriter.h"
+#include "parallel.h"
+#include "reslice.h"
+#include "metadata.h"
+#include "overlay.h"
+#include "labels.h"
+#include "probe.h"
+#include "roi.h"
+#include "crop.h"
+#include "segment.h"
+#include "isosurface.h"
+#include "minmax.h"
+#include "input.h"
+#include "adaptive.h"
+#include "downsample.h"
+#include "cache.h"
+#include "dataset.h"
+#include "budget.h"
+#include "session.h"
+#include "demo.h"
+#include "startup.h"
+
+#include <filesystem>
+
+
+StartupTrace trace;                                     // phases of startup (constructed before main, so it times the whole launch)
 GLFWwindow* window;                                     // pointer to the GLFW window that will be created (used in GLFW calls to request properties)
 const char* glsl_version = "#version 130";              // specify the version of GLSL
 ImVec4 clear_color = ImVec4(0.0f, 0.0f, 0.0f, 1.00f);   // specify the OpenGL color used to clear the back buffer
 float gui_VolumeSize[] = { 1.0f, 1.0f, 1.0f };            // initialize the volume size to 1 (uniform)
 float gui_VolumeSlice[] = { 0.5f, 0.5f, 0.5f };         // current volume slice being displayed [0.0, 1.0]
 float coords[] = { 0.0f, 0.0f, 0.0f };
+float coords_physical[] = { 0.0f, 0.0f, 0.0f };         // selected position in physical units (see vol_meta)
+VolumeMetadata vol_meta;                                // voxel spacing and origin of the loaded volume
+bool gui_ObliqueEnable = false;                         // display the user-defined oblique plane in the 3D view
+float gui_ObliqueOffset = 0.0f;                         // distance of the oblique plane from the center of the volume (along its normal)
+glm::mat4 oblique_rotation(1.0f);                       // orientation of the oblique plane (its normal is the rotated z axis)
+bool oblique_reset = false;                             // flag set by the GUI to reset the oblique plane orientation
+bool oblique_export = false;                            // flag set by the GUI to resample the oblique plane on the CPU and save it
 bool window_focused = false;
 tira::camera cam;                                       // create a perspective camera for 3D visualization of the volume
-bool right_mouse_pressed = false;                       // flag indicates when the right mouse button is being dragged
-bool left_mouse_pressed = false;                        // flag indicates when the left mouse button is being dragged
+InputState mouse;                                       // drags in progress (orbit, oblique rotation, crop box, measurement)
+InputQueue input;                                       // mouse events recorded by the GLFW callbacks since the last frame
 
 tira::glVolume<unsigned char>* vol;                     // grid storing volumetric information
-tira::glShader* vol_shader;                             // shader for rendering volumetric information
+DemoVolume demo;                                        // shown (computed in the shader) while no volume is loaded
+MinMaxGrid vol_ranges;                                  // per-brick value ranges of vol (used to skip empty regions)
+glProgram* vol_shader;                                  // shader for rendering volumetric information
 tira::glGeometry* axis;                                 // geometry for the axes (represented as cylinders)
-tira::glShader* axis_shader;                            // shader used to render axes (x=red, y=green, z=blue)
+glProgram* axis_shader;                                 // shader used to render axes (x=red, y=green, z=blue)
+tira::glGeometry* slice_rect;                           // rectangle used to render volume cross-sections
+OverlayStack overlays;                                  // additional volumes composited over vol in the slicer shader
+LabelVolume labels;                                     // integer label volume (segmentation) drawn over the slices
+ThresholdPreview threshold;                             // binary threshold drawn over the slices
+ComponentStats components;                              // result of the last connected-components labeling
+std::vector<uint32_t> components_largest;               // ids of the largest components (listed in the GUI)
+bool components_run = false;                            // flag set by the GUI to label the connected components
+glIsosurface isosurface;                                // isosurface of the primary volume drawn in the 3D view
+glAdaptiveView view3d;                                  // renders the 3D view at reduced resolution while the camera moves
+MemoryBudget memory;                                    // limits on the GPU and host memory of all resident resources
+ProbeResult probe;                                      // voxel values under the mouse cursor (shown in the GUI)
+glPicker picker;                                        // reads single voxels from overlay/label textures
+
+int gui_RoiTool = 0;                                    // measurement tool (0 = none, 1 = line profile, 2 = box ROI, 3 = sphere ROI)
+float gui_RoiDepth = 16.0f;                             // thickness (in voxels) of box ROIs perpendicular to the view they are drawn in
+int gui_RoiChannel = 0;                                 // channel used for profiles and ROI statistics
+std::vector<float> roi_profile;                         // intensity profile along the drawn line
+RoiStats roi_stats;                                     // statistics inside the drawn box/sphere
+std::string vol_filename;                               // file the volume was loaded from (empty for the generated volume)
+std::string vol_source;                                 // file the user opened (vol_filename may be its downsampled copy)
+int vol_downsample = 1;                                 // factor the displayed volume was reduced by
+std::string labels_filename;                            // file the labels were loaded from (empty if computed or none)
+int gui_LoadDownsample = 1;                             // quick look: reduce volumes by this factor along every axis as they are loaded (1 = full resolution)
+bool gui_CropEnable = false;                            // display the crop box in the 3D view (ctrl + left drag moves its faces)
+int gui_CropLo[3] = { 0, 0, 0 };                        // first voxel inside the crop box along x, y, z
+int gui_CropHi[3] = { 0, 0, 0 };                        // last voxel inside the crop box along x, y, z
+int crop_dims[3] = { 1, 1, 1 };                         // volume size in voxels (limits of the crop box)
+int gui_CropFormat = CROP_NPY;                          // file format used by the subvolume export
+bool crop_export = false;                               // flag set by the GUI to export the subvolume inside the crop box
+float crop_screen[16];                                  // window coordinates of the crop box corners (x, y pairs)
+
+SweepSettings sweep_settings;                           // parameters for exporting an animated sweep (edited in the GUI)
+bool sweep_export = false;                              // flag set by the GUI to start a sweep export
+bool screenshot = false;                                // flag set by the GUI to save the viewports to a PNG file
+
+#define SESSION_PREVIEW 4                               // a session is first shown from the copy of its volume downsampled by this factor
+Session session;                                        // last restored session
+bool session_pending = false;                           // the volume of the session is shown as a preview until the next frame
+bool session_restore = false;                           // flag set by the GUI to restore the last session
+
+/// Identifiers for the viewports (quadrants) of the display
+enum ViewId { VIEW_3D = 0, VIEW_XY, VIEW_XZ, VIEW_YZ, VIEW_ALL };
 
 
 //bool button_click = false;
@@ -40,11 +119,16 @@ std::string SlicerVertexSource =                                  // Source code
 "uniform float slider;\n"
 "uniform mat4 view;\n"
 "uniform int axis;\n"
+"uniform mat4 M;\n"
+"uniform vec3 volume_size;\n"
 "out vec3 vertex_tex;\n"
 "void main()\n"
 "{\n"
 "    gl_Position = MVP * aPos;\n"
-"    if (axis == 2) {\n"
+"    if (axis == 3) {\n"
+"        vertex_tex = (M * aPos).xyz / volume_size + 0.5;\n"
+"    }\n"
+"    else if (axis == 2) {\n"
 "        vertex_tex = vec3(texcoords.x, texcoords.y, slider);\n"
 "    }\n"
 "    else if (axis == 1)\n"
@@ -63,10 +147,88 @@ std::string SlicerFragmentSource =                               // Source code
 "in vec3 vertex_tex;\n"
 "out vec4 colors;\n"
 "uniform sampler3D volumeTexture;\n"
+"uniform int demo;\n"                                            // no volume is loaded: show the demo volume (see DemoVolume)
+"uniform int overlay_count;\n"                                   // number of active overlays (see OverlayStack::Bind)
+"uniform sampler3D overlay0, overlay1, overlay2, overlay3;\n"
+"uniform int overlay_colormap0, overlay_colormap1, overlay_colormap2, overlay_colormap3;\n"
+"uniform int overlay_blend0, overlay_blend1, overlay_blend2, overlay_blend3;\n"
+"uniform int overlay_channels0, overlay_channels1, overlay_channels2, overlay_channels3;\n"
+"uniform float overlay_opacity0, overlay_opacity1, overlay_opacity2, overlay_opacity3;\n"
+"uniform usampler3D labelTexture;\n"                              // integer label ids (see LabelVolume)
+"uniform int label_enable;\n"
+"uniform int label_outline;\n"
+"uniform float label_opacity;\n"
+"uniform int axis;\n"
+"uniform int threshold_enable;\n"                                 // binary threshold preview (see ThresholdPreview)
+"uniform int threshold_channel;\n"
+"uniform float threshold_lo;\n"
+"uniform float threshold_hi;\n"
+"uniform float threshold_opacity;\n"
+"vec3 label_color(uint id)\n"                                     // hash the label id into a bright, stable color
+"{\n"
+"    uint h = id * 2654435761u;\n"
+"    h ^= h >> 15;\n"
+"    h *= 2246822519u;\n"
+"    h ^= h >> 13;\n"
+"    return vec3(float(h & 255u), float((h >> 8) & 255u), float((h >> 16) & 255u)) / 255.0 * 0.75 + 0.25;\n"
+"}\n"
+"bool label_boundary(ivec3 p, ivec3 size, uint id)\n"           // true if an in-plane neighbor has a different label
+"{\n"
+"    ivec3 du = (axis == 0) ? ivec3(0, 1, 0) : ivec3(1, 0, 0);\n"
+"    ivec3 dv = (axis >= 2) ? ivec3(0, 1, 0) : ivec3(0, 0, 1);\n"
+"    ivec3 dw = ivec3(0, 0, 1);\n"
+"    int n = (axis == 3) ? 6 : 4;\n"                                   // the oblique plane checks all six neighbors
+"    ivec3 offsets[6] = ivec3[6](du, -du, dv, -dv, dw, -dw);\n"
+"    for (int i = 0; i < n; i++) {\n"
+"        ivec3 q = clamp(p + offsets[i], ivec3(0), size - 1);\n"
+"        if (texelFetch(labelTexture, q, 0).r != id) return true;\n"
+"    }\n"
+"    return false;\n"
+"}\n"
+"vec3 colormap(vec4 s, int channels, int map)\n"
+"{\n"
+"    float v = (channels == 1) ? s.r : max(s.r, max(s.g, s.b));\n"
+"    if (map == 0) return (channels == 1) ? vec3(s.r) : ((channels == 2) ? vec3(s.rg, 0.0) : s.rgb);\n"
+"    if (map == 1) return vec3(v, 0.0, 0.0);\n"
+"    if (map == 2) return vec3(0.0, v, 0.0);\n"
+"    if (map == 3) return vec3(0.0, 0.0, v);\n"
+"    if (map == 4) return vec3(v, 0.0, v);\n"
+"    return clamp(vec3(3.0 * v, 3.0 * v - 1.0, 3.0 * v - 2.0), 0.0, 1.0);\n"   // hot
+"}\n"
+"vec4 demo_color(vec3 p)\n"                                     // same as DemoVolume::Value (256 voxels, grid lines every 32)
+"{\n"
+"    ivec3 v = clamp(ivec3(p * 256.0), ivec3(0), ivec3(255));\n"
+"    vec3 c = vec3(v) / 255.0;\n"
+"    return vec4(any(equal(v % 32, ivec3(0))) ? 0.5 * c : c, 1.0);\n"
+"}\n"
+"vec3 composite(vec3 base, vec3 c, float opacity, int blend)\n"
+"{\n"
+"    if (blend == 1) return base + opacity * c;\n"
+"    if (blend == 2) return max(base, opacity * c);\n"
+"    return mix(base, c, opacity);\n"
+"}\n"
 "void main()\n"
 "{\n"
 "    float lineWidthHalf = 0.002f;\n"
-"    colors = texture(volumeTexture, vertex_tex);\n"
+"    if (any(lessThan(vertex_tex, vec3(0.0))) || any(greaterThan(vertex_tex, vec3(1.0)))) discard;\n"
+"    colors = (demo == 1) ? demo_color(vertex_tex) : texture(volumeTexture, vertex_tex);\n"
+"    vec3 rgb = colors.rgb;\n"
+"    if (overlay_count > 0) rgb = composite(rgb, colormap(texture(overlay0, vertex_tex), overlay_channels0, overlay_colormap0), overlay_opacity0, overlay_blend0);\n"
+"    if (overlay_count > 1) rgb = composite(rgb, colormap(texture(overlay1, vertex_tex), overlay_channels1, overlay_colormap1), overlay_opacity1, overlay_blend1);\n"
+"    if (overlay_count > 2) rgb = composite(rgb, colormap(texture(overlay2, vertex_tex), overlay_channels2, overlay_colormap2), overlay_opacity2, overlay_blend2);\n"
+"    if (overlay_count > 3) rgb = composite(rgb, colormap(texture(overlay3, vertex_tex), overlay_channels3, overlay_colormap3), overlay_opacity3, overlay_blend3);\n"
+"    if (threshold_enable == 1) {\n"
+"        float t = colors[threshold_channel];\n"
+"        if (t >= threshold_lo && t <= threshold_hi) rgb = mix(rgb, vec3(1.0, 0.1, 0.1), threshold_opacity);\n"
+"    }\n"
+"    if (label_enable == 1) {\n"
+"        ivec3 size = textureSize(labelTexture, 0);\n"
+"        ivec3 p = clamp(ivec3(vertex_tex * vec3(size)), ivec3(0), size - 1);\n"
+"        uint id = texelFetch(labelTexture, p, 0).r;\n"
+"        if (id != 0u && (label_outline == 0 || label_boundary(p, size, id)))\n"
+"            rgb = mix(rgb, label_color(id), (label_outline == 1) ? 1.0 : label_opacity);\n"
+"    }\n"
+"    colors = vec4(min(rgb, vec3(1.0)), colors.a);\n"
 "};\n";
 
 std::string AxesVertexSource =
@@ -95,36 +257,41 @@ std::string AxesFragmentSource =
 "    color = FragColor;\n"
 "};\n";
 
-double mouse_x, mouse_y;
 double THETA = 0.02;
 
+static_assert(INPUT_BUTTON_LEFT == GLFW_MOUSE_BUTTON_LEFT && INPUT_BUTTON_RIGHT == GLFW_MOUSE_BUTTON_RIGHT &&
+              INPUT_PRESS == GLFW_PRESS && INPUT_RELEASE == GLFW_RELEASE &&
+              INPUT_MOD_SHIFT == GLFW_MOD_SHIFT && INPUT_MOD_CONTROL == GLFW_MOD_CONTROL, "input.h must match GLFW");
+
+/// <summary>
+/// The window callbacks only record events; they are applied once per frame by ProcessInput() (input.cpp)
+/// </summary>
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
-    if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
-        right_mouse_pressed = true;
-        glfwGetCursorPos(window, &mouse_x, &mouse_y);                   // save the mouse position when the right button is pressed
-    }
-    if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE)
-        right_mouse_pressed = false;
-
-    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-        left_mouse_pressed = true;
-    }
-    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE)
-        left_mouse_pressed = false;
+    input.Button(button, action, mods);
 }
         
 static void cursor_position_callback(GLFWwindow* window, double xpos, double ypos)
 {
-    if (right_mouse_pressed) {
-        double dx = xpos - mouse_x;
-        double dy = ypos - mouse_y;
-
-        mouse_x = xpos;
-        mouse_y = ypos;
+    input.Move(xpos, ypos);
+}
 
+/// <summary>
+/// Orbit the camera and rotate the oblique plane as the mouse is dragged
+/// </summary>
+InputHandlers ViewHandlers() {
+    InputHandlers handlers;
+    handlers.orbit = [](double dx, double dy) {
         cam.orbit(-THETA * dx, THETA * dy);
-    }
+    };
+    handlers.rotate = [](double dx, double dy) {
+        // rotate the plane about the camera's up and right vectors so that it follows the mouse in the 3D view
+        glm::vec3 up = glm::normalize(cam.getUp());
+        glm::vec3 right = glm::normalize(glm::cross(cam.getLookAt() - cam.getPosition(), up));
+        oblique_rotation = glm::rotate(glm::mat4(1.0f), (float)(THETA * dx), up) *
+                           glm::rotate(glm::mat4(1.0f), (float)(THETA * dy), right) * oblique_rotation;
+    };
+    return handlers;
 }
 
 glm::vec2 VolSizeMax(float aspect, glm::vec3 volume_size) {
@@ -315,42 +482,55 @@ bool IsInRange(glm::vec3 num, glm::vec3 MaxRange) {
     return false;
 }
 
-void coordinates_select(GLFWwindow* window, glm::vec3 &coordinates, int display_w, int display_h, glm::vec3 volume_size, glm::vec3 &plane_position) {
-    
-    double coord_x, coord_y;
-    glfwGetCursorPos(window, &coord_x, &coord_y);
+/// <summary>
+/// Maps a cursor position (in window pixels) to world coordinates on the slice displayed in the quadrant under it
+/// </summary>
+/// <param name="coordinates">Receives the world-space position (unchanged if the cursor is over the 3D view)</param>
+/// <returns>ViewId of the quadrant under the cursor</returns>
+int CursorToWorld(double coord_x, double coord_y, int display_w, int display_h, glm::vec3 volume_size, glm::vec3 plane_position, glm::vec3& coordinates) {
     float aspect = (float)display_w / (float)display_h;
     glm::vec2 ortho_world = VolSizeMax(aspect, volume_size);
     int half_disp_w = display_w / 2;
     int half_disp_h = display_h / 2;
-    bool InRange = false;
-
 
     // XY plane
     // window x: (800, 1600)   y: (0, 600)
     // maps all coordinates to the VolumeSize * aspect ratio
-    if (coord_x > half_disp_w && coord_y < half_disp_h && left_mouse_pressed) {
+    if (coord_x > half_disp_w && coord_y < half_disp_h) {
         coordinates.x = ((coord_x / half_disp_w) - 1) * ortho_world.x - (ortho_world.x / 2.0f);
         coordinates.y = -((coord_y / half_disp_h) * ortho_world.y - (ortho_world.y / 2.0f));
-        coordinates.z = plane_position.z - 0.5f;
+        coordinates.z = (plane_position.z - 0.5f) * volume_size.z;
+        return VIEW_XY;
     }
     // XZ plane
     // window x: (800, 1600)   y: (600, 1200)
     // maps all coordinates to the VolumeSize * aspect ratio
-    if (coord_x > half_disp_w && coord_y > half_disp_h && left_mouse_pressed) {
+    if (coord_x > half_disp_w && coord_y > half_disp_h) {
         coordinates.x = ((coord_x / half_disp_w) - 1) * ortho_world.x - (ortho_world.x / 2.0f);
-        coordinates.y = plane_position.y - 0.5f;
+        coordinates.y = (plane_position.y - 0.5f) * volume_size.y;
         coordinates.z = -(((coord_y / half_disp_h) - 1) * ortho_world.y - (ortho_world.y/ 2.0f));
+        return VIEW_XZ;
     }
 
     // YZ plane
     // window x: (800, 1600)   y: (0, 600)
     // maps all coordinates to the VolumeSize * aspect ratio
-    if (coord_x < half_disp_w && coord_y > half_disp_h && left_mouse_pressed) {
-        coordinates.x = plane_position.x - 0.5f;
+    if (coord_x < half_disp_w && coord_y > half_disp_h) {
+        coordinates.x = (plane_position.x - 0.5f) * volume_size.x;
         coordinates.y = (coord_x / half_disp_w) * ortho_world.x - (ortho_world.x / 2.0f);
         coordinates.z = -(((coord_y / half_disp_h) - 1) * ortho_world.y - (ortho_world.y / 2.0f));
+        return VIEW_YZ;
     }
+    return VIEW_3D;
+}
+
+/// <summary>
+/// Select the position under the cursor (from a left click or drag) and move the slices to it
+/// </summary>
+void coordinates_select(double coord_x, double coord_y, glm::vec3 &coordinates, int display_w, int display_h, glm::vec3 volume_size, glm::vec3 &plane_position) {
+    bool InRange = false;
+
+    CursorToWorld(coord_x, coord_y, display_w, display_h, volume_size, plane_position, coordinates);
 
     // maps back to (0,1)
     MaxRange(coordinates, volume_size / 2.0f);                          // if any of the selected coordinates are outside the volume, sets it the nearest value
@@ -365,9 +545,306 @@ void coordinates_select(GLFWwindow* window, glm::vec3 &coordinates, int display_
 
 }
 
+/// <summary>
+/// Returns the size of the primary volume (the demo volume if no file is loaded) without generating the demo: the
+/// data pointer is null until its voxels are needed
+/// </summary>
+VoxelGrid VolumeShape() {
+    VoxelGrid grid;
+    if (vol->X() == 0) {
+        grid.data = demo.Data();
+        grid.X = DemoVolume::X;
+        grid.Y = DemoVolume::Y;
+        grid.Z = DemoVolume::Z;
+        grid.C = DemoVolume::C;
+        return grid;
+    }
+    grid.data = vol->data();
+    grid.X = vol->X();
+    grid.Y = vol->Y();
+    grid.Z = vol->Z();
+    grid.C = vol->C();
+    return grid;
+}
+
+/// <summary>
+/// Returns the size of the volume in world space: its physical extent (voxels * spacing) scaled so that the
+/// largest dimension is 1
+/// </summary>
+glm::vec3 DefaultVolumeSize() {
+    VoxelGrid shape = VolumeShape();
+    glm::vec3 extent = glm::vec3((float)shape.X, (float)shape.Y, (float)shape.Z) * vol_meta.spacing;
+    float extent_max = std::max(extent.x, std::max(extent.y, extent.z));
+    if (extent_max <= 0.0f) return glm::vec3(1.0f);
+    return extent / extent_max;
+}
+
+/// <summary>
+/// Converts a selected position in world space (as stored in coords) into physical units
+/// </summary>
+glm::vec3 PhysicalPosition(glm::vec3 coordinates, glm::vec3 volume_size) {
+    VoxelGrid shape = VolumeShape();
+    glm::vec3 dims = glm::vec3((float)shape.X, (float)shape.Y, (float)shape.Z);
+    glm::vec3 index = (coordinates / volume_size + glm::vec3(0.5f)) * dims - glm::vec3(0.5f);  // continuous voxel index
+    return vol_meta.origin + index * vol_meta.spacing;
+}
+
+/// <summary>
+/// Update the hover probe: map the cursor to a voxel on the slice under it and look up its value(s). The primary
+/// volume is read from its host copy; overlays and labels (which have no host copy) are read with a 1-voxel GPU pick.
+/// </summary>
+void UpdateProbe(double coord_x, double coord_y, int display_w, int display_h, glm::vec3 volume_size, glm::vec3 plane_position) {
+    glm::vec3 coordinates;
+    probe.view = CursorToWorld(coord_x, coord_y, display_w, display_h, volume_size, plane_position, coordinates);
+    glm::vec3 tex = coordinates / volume_size + glm::vec3(0.5f);                   // normalized texture coordinates
+    probe.valid = (probe.view != VIEW_3D && tex.x >= 0.0f && tex.x <= 1.0f && tex.y >= 0.0f && tex.y <= 1.0f && tex.z >= 0.0f && tex.z <= 1.0f);
+    if (!probe.valid) return;
+
+    auto voxel_index = [&](size_t X, size_t Y, size_t Z) {                          // voxel containing tex in a grid of the given size
+        return glm::ivec3(std::min((int)(tex.x * X), (int)X - 1), std::min((int)(tex.y * Y), (int)Y - 1), std::min((int)(tex.z * Z), (int)Z - 1));
+    };
+
+    VoxelGrid shape = VolumeShape();
+    probe.voxel = voxel_index(shape.X, shape.Y, shape.Z);
+    probe.physical = vol_meta.origin + glm::vec3((float)probe.voxel.x, (float)probe.voxel.y, (float)probe.voxel.z) * vol_meta.spacing;
+    probe.channels = std::min<size_t>(shape.C, 4);
+    for (size_t c = 0; c < probe.channels; c++) {
+        if (shape.data) probe.value[c] = shape.voxel(probe.voxel.x, probe.voxel.y, probe.voxel.z)[c];
+        else probe.value[c] = DemoVolume::Value(probe.voxel.x, probe.voxel.y, probe.voxel.z, c);   // the demo is not generated
+    }
+
+    unsigned int picked[4];
+    probe.has_label = labels.Loaded() && picker.PickUint(labels.Texture(), voxel_index(labels.X, labels.Y, labels.Z), picked);
+    if (probe.has_label) probe.label = picked[0];
+
+    probe.overlay_count = overlays.size();
+    for (size_t i = 0; i < overlays.size(); i++)
+        picker.PickFloat(overlays[i].texture, voxel_index(overlays[i].X, overlays[i].Y, overlays[i].Z), probe.overlay[i]);
+}
+
+/// <summary>
+/// Build the brick ranges of the primary volume (once per loaded volume) and upload them as a texture
+/// </summary>
+void BuildRanges() {
+    auto start = std::chrono::steady_clock::now();
+    vol_ranges.Build(VolumeShape());
+    vol_ranges.Upload(0);
+    glm::ivec3 b = vol_ranges.Bricks();
+    trace.Timing("built the " + std::to_string(b.x) + "x" + std::to_string(b.y) + "x" + std::to_string(b.z) + " brick range grid", start);
+}
+
+/// <summary>
+/// Returns a view of the host copy of the primary volume for the CPU-side tools
+/// </summary>
+VoxelGrid VolumeGrid() {
+    VoxelGrid grid = VolumeShape();
+    if (!grid.data && vol->X() == 0) {                                             // first use of the demo volume
+        demo.Generate();
+        BuildRanges();
+        view3d.Restart();
+        grid.data = demo.Data();
+    }
+    return grid;
+}
+
+/// <summary>
+/// Bind the primary volume to texture unit 0 and tell the slicer shader (if given) whether to compute the demo
+/// </summary>
+void BindVolume(glProgram* shader = nullptr) {
+    bool show_demo = (vol->X() == 0);
+    if (show_demo) demo.Bind();
+    else vol->Bind();
+    if (shader) shader->SetUniform1i("demo", show_demo ? 1 : 0);
+}
+
+/// <summary>
+/// Report the footprint of every resident resource to the memory budget (cheap enough to call every frame)
+/// </summary>
+void UpdateMemoryUsage() {
+    size_t volume_bytes = vol->X() * vol->Y() * vol->Z() * vol->C();
+    memory.Set("Volume", volume_bytes + demo.GpuBytes(), volume_bytes + demo.HostBytes());   // texture and host copy
+    memory.Set("Overlays", overlays.Bytes(), 0);                                // host copies are released after the upload
+    memory.Set("Labels", labels.bytes(), 0);
+    memory.Set("Brick ranges", vol_ranges.GpuBytes(), vol_ranges.HostBytes());
+    memory.Set("Isosurface", isosurface.GpuBytes(), isosurface.HostBytes(),    // a hidden surface is rebuilt when shown again
+        isosurface.visible ? std::function<void()>() : [] { isosurface.Reset(); isosurface.Destroy(); });
+    memory.Set("3D view buffers", view3d.Bytes(), 0);
+
+    static auto last_query = std::chrono::steady_clock::time_point();
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_query > std::chrono::seconds(1)) {                           // driver figures change slowly
+        memory.QueryDevice();
+        last_query = now;
+    }
+}
+
+/// <summary>
+/// Recompute the line profile or ROI statistics for the drawn measurement. Both ends of the drag must lie in the
+/// same 2D view; the ROI extends gui_RoiDepth voxels (box) or the drawn radius (sphere) out of the view's plane.
+/// </summary>
+void UpdateMeasurement(int display_w, int display_h, glm::vec3 volume_size, glm::vec3 plane_position) {
+    glm::vec3 c0, c1;
+    int view0 = CursorToWorld(mouse.roi_screen[0], mouse.roi_screen[1], display_w, display_h, volume_size, plane_position, c0);
+    int view1 = CursorToWorld(mouse.roi_screen[2], mouse.roi_screen[3], display_w, display_h, volume_size, plane_position, c1);
+    if (view0 == VIEW_3D || view0 != view1) return;
+
+    VoxelGrid grid = VolumeGrid();
+    glm::vec3 dims((float)grid.X, (float)grid.Y, (float)grid.Z);
+    glm::vec3 v0 = (c0 / volume_size + glm::vec3(0.5f)) * dims - glm::vec3(0.5f);  // voxel coordinates of the drag end points
+    glm::vec3 v1 = (c1 / volume_size + glm::vec3(0.5f)) * dims - glm::vec3(0.5f);
+    size_t channel = std::min((size_t)std::max(gui_RoiChannel, 0), grid.C - 1);
+
+    if (gui_RoiTool == 1) {
+        size_t samples = std::min<size_t>(4096, (size_t)std::ceil(glm::length(v1 - v0)) + 1);
+        roi_profile = SampleProfile(grid, v0, v1, channel, samples);
+        return;
+    }
+
+    Roi roi;
+    int normal = (view0 == VIEW_XY) ? 2 : (view0 == VIEW_XZ) ? 1 : 0;                 // axis perpendicular to the view
+    if (gui_RoiTool == 2) {
+        roi.shape = ROI_BOX;
+        glm::vec3 lo = glm::min(v0, v1), hi = glm::max(v0, v1);
+        lo[normal] = v0[normal] - 0.5f * gui_RoiDepth;
+        hi[normal] = v0[normal] + 0.5f * gui_RoiDepth;
+        roi.lo = glm::ivec3((int)std::round(lo.x), (int)std::round(lo.y), (int)std::round(lo.z));
+        roi.hi = glm::ivec3((int)std::round(hi.x), (int)std::round(hi.y), (int)std::round(hi.z));
+    }
+    else {
+        roi.shape = ROI_SPHERE;
+        roi.center = v0;
+        float r = glm::length((v1 - v0) * vol_meta.spacing);                           // radius in physical units
+        roi.radius = glm::vec3(r) / vol_meta.spacing;
+    }
+    roi_stats = ComputeRoiStats(grid, roi, channel, &vol_ranges);
+}
+
+/// <summary>
+/// Project a world-space point into window coordinates of the 3D view (upper left quadrant)
+/// </summary>
+glm::vec2 Project3DView(glm::vec3 p, int display_w, int display_h, glm::vec3 volume_size) {
+    glm::mat4 P = createProjectionMatrix((float)display_w / (float)display_h, volume_size);
+    glm::vec4 clip = P * cam.viewmatrix() * glm::vec4(p, 1.0f);
+    glm::vec2 ndc = glm::vec2(clip.x, clip.y) / clip.w;
+    return glm::vec2((ndc.x * 0.5f + 0.5f) * (display_w / 2), (0.5f - ndc.y * 0.5f) * (display_h / 2));
+}
+
+/// <summary>
+/// Reset the crop box to the whole volume
+/// </summary>
+void ResetCrop() {
+    VoxelGrid shape = VolumeShape();
+    size_t dims[3] = { shape.X, shape.Y, shape.Z };
+    for (int i = 0; i < 3; i++) {
+        crop_dims[i] = (int)dims[i];
+        gui_CropLo[i] = 0;
+        gui_CropHi[i] = (int)dims[i] - 1;
+    }
+}
+
+/// <summary>
+/// Clamp the crop box, project its corners into the 3D view and apply a ctrl + drag. The face whose projected
+/// center is closest to the cursor when the drag starts follows the cursor along the projection of its normal.
+/// </summary>
+void UpdateCropBox(int display_w, int display_h, glm::vec3 volume_size) {
+    for (int i = 0; i < 3; i++) {
+        gui_CropLo[i] = std::clamp(gui_CropLo[i], 0, crop_dims[i] - 1);
+        gui_CropHi[i] = std::clamp(gui_CropHi[i], gui_CropLo[i], crop_dims[i] - 1);
+    }
+
+    // the box covers whole voxels: voxel i spans [i, i + 1] / dims in texture space
+    glm::vec3 dims((float)crop_dims[0], (float)crop_dims[1], (float)crop_dims[2]);
+    glm::vec3 lo = (glm::vec3((float)gui_CropLo[0], (float)gui_CropLo[1], (float)gui_CropLo[2]) / dims - glm::vec3(0.5f)) * volume_size;
+    glm::vec3 hi = (glm::vec3((float)gui_CropHi[0] + 1, (float)gui_CropHi[1] + 1, (float)gui_CropHi[2] + 1) / dims - glm::vec3(0.5f)) * volume_size;
+    for (int c = 0; c < 8; c++) {
+        glm::vec3 corner((c & 1) ? hi.x : lo.x, (c & 2) ? hi.y : lo.y, (c & 4) ? hi.z : lo.z);
+        glm::vec2 p = Project3DView(corner, display_w, display_h, volume_size);
+        crop_screen[2 * c + 0] = p.x;
+        crop_screen[2 * c + 1] = p.y;
+    }
+
+    static int face = -1;                                                           // dragged face (2 * axis + side)
+    static float accumulated = 0.0f;                                                // fraction of a voxel dragged so far
+    if (!mouse.crop_drag) {
+        face = -1;
+        return;
+    }
+    double x = input.X(), y = input.Y();
+    glm::vec3 center = 0.5f * (lo + hi);
+    if (face < 0) {
+        if (mouse.x > display_w / 2 || mouse.y > display_h / 2) return;            // drags start in the 3D view
+        float nearest = 1e30f;
+        for (int f = 0; f < 6; f++) {
+            glm::vec3 c = center;
+            c[f / 2] = (f % 2) ? hi[f / 2] : lo[f / 2];
+            glm::vec2 d = Project3DView(c, display_w, display_h, volume_size) - glm::vec2((float)mouse.x, (float)mouse.y);
+            if (glm::dot(d, d) < nearest) {
+                nearest = glm::dot(d, d);
+                face = f;
+            }
+        }
+        accumulated = 0.0f;
+    }
+
+    int a = face / 2;
+    glm::vec3 c = center;
+    c[a] = (face % 2) ? hi[a] : lo[a];
+    glm::vec3 step(0.0f);
+    step[a] = volume_size[a] / dims[a];                                             // one voxel along the face normal
+    glm::vec2 dir = Project3DView(c + step, display_w, display_h, volume_size) - Project3DView(c, display_w, display_h, volume_size);
+    if (glm::dot(dir, dir) > 1e-6f) {
+        accumulated += glm::dot(glm::vec2((float)(x - mouse.x), (float)(y - mouse.y)), dir) / glm::dot(dir, dir);
+        int voxels = (int)accumulated;
+        accumulated -= (float)voxels;
+        int* bound = (face % 2) ? &gui_CropHi[a] : &gui_CropLo[a];
+        *bound += voxels;
+        gui_CropLo[a] = std::clamp(gui_CropLo[a], 0, crop_dims[a] - 1);
+        gui_CropHi[a] = std::clamp(gui_CropHi[a], gui_CropLo[a], crop_dims[a] - 1);
+    }
+    mouse.x = x;
+    mouse.y = y;
+}
+
+/// <summary>
+/// Write the voxels inside the crop box next to the source volume. Loaded volumes are streamed from their file
+/// (in their original data type); the generated volume is written from memory.
+/// </summary>
+void ExportCrop() {
+    glm::ivec3 lo(gui_CropLo[0], gui_CropLo[1], gui_CropLo[2]);
+    glm::ivec3 hi(gui_CropHi[0], gui_CropHi[1], gui_CropHi[2]);
+    std::string stem = vol_filename.empty() ? std::string("volume") : vol_filename.substr(0, vol_filename.find_last_of('.'));
+    std::string destination = stem + "_crop" + ((gui_CropFormat == CROP_RAW) ? ".raw" : ".npy");
+
+    bool saved;
+    if (vol_filename.empty()) {
+        VoxelGrid grid = VolumeGrid();
+        saved = ExportSubvolume(grid, destination, lo, hi, gui_CropFormat);
+    }
+    else
+        saved = ExportSubvolume(vol_filename, destination, lo, hi, gui_CropFormat);
+
+    if (saved && vol_meta.loaded) {                                                 // the subvolume starts at voxel lo
+        VolumeMetadata meta = vol_meta;
+        meta.origin += glm::vec3((float)lo.x, (float)lo.y, (float)lo.z) * meta.spacing;
+        SaveVolumeMetadata(destination + ".json", meta);
+    }
+}
+
+/// <summary>
+/// Place the camera so that the whole volume is visible in the 3D view
+/// </summary>
+/// <returns>largest dimension of the volume</returns>
+float FitCamera() {
+    float vs_max = std::max(gui_VolumeSize[0], std::max(gui_VolumeSize[1], gui_VolumeSize[2]));         // find the maximum size of the volume
+    cam.position(2 * vs_max, 2 * vs_max, 2 * vs_max);                                                // eye
+    cam.lookat(0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);                                                     // center and up
+    return vs_max;
+}
+
 void resetPlane(float vs_max) {
+    glm::vec3 default_size = DefaultVolumeSize();
     for (int i = 0; i < 3; i++) {
-        gui_VolumeSize[i] = 1.0f;
+        gui_VolumeSize[i] = default_size[i];
         gui_VolumeSlice[i] = 0.5f;
         coords[i] = 0.0f;
     }
@@ -424,7 +901,7 @@ void inline draw_axes(glm::mat4 projection, glm::mat4 view, glm::vec3 volume_siz
 /// <param name="rect"></param>
 /// <param name="material"></param>
 void inline RenderSlices(glm::vec3 volume_size, glm::vec3 plane_positions, glm::mat4 V, glm::mat4 P,
-    tira::glGeometry rect, tira::glShader shader) {
+    tira::glGeometry rect, glProgram& shader) {
 
     glm::mat4 M1, M2, M3;                                   // create a model matrix
     glm::mat4 rotation;                                     // create a rotation matrix
@@ -432,7 +909,10 @@ void inline RenderSlices(glm::vec3 volume_size, glm::vec3 plane_positions, glm::
     glm::mat4 translation;                                  // create a translation matrix
 
     vol_shader->Bind();
-    vol->Bind();
+    BindVolume(vol_shader);
+    overlays.Bind(vol_shader);                              // overlays are composited in the same pass
+    labels.Bind(vol_shader);
+    threshold.Bind(vol_shader, VolumeShape().C);
     {
         // create a model matrix that scales and orients the XY plane
         rotation = createRotationMatrix(0, 1);
@@ -473,6 +953,165 @@ void inline RenderSlices(glm::vec3 volume_size, glm::vec3 plane_positions, glm::
     draw_axes(P, V, volume_size, plane_positions);
 }
 
+/// <summary>
+/// Returns the model matrix of the oblique plane: a square large enough to cover the volume along any
+/// orientation, rotated by oblique_rotation and displaced along its normal by gui_ObliqueOffset
+/// </summary>
+glm::mat4 createObliqueMatrix(glm::vec3 volume_size) {
+    float diagonal = glm::length(volume_size);
+    glm::vec3 normal = glm::vec3(oblique_rotation * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+    glm::mat4 translation = glm::translate(glm::mat4(1.0f), normal * gui_ObliqueOffset);
+    glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(diagonal, diagonal, 1.0f));
+    return translation * oblique_rotation * scale;
+}
+
+/// <summary>
+/// Renders the oblique plane using the same sampler3D path as the axis-aligned planes (fragments outside of
+/// the volume are discarded by the shader)
+/// </summary>
+void RenderOblique(glm::vec3 volume_size, glm::mat4 V, glm::mat4 P) {
+    glm::mat4 M = createObliqueMatrix(volume_size);
+    vol_shader->Bind();
+    BindVolume(vol_shader);
+    overlays.Bind(vol_shader);
+    labels.Bind(vol_shader);
+    threshold.Bind(vol_shader, VolumeShape().C);
+    vol_shader->SetUniformMat4f("MVP", P * V * M);
+    vol_shader->SetUniformMat4f("M", M);
+    vol_shader->SetUniform3f("volume_size", volume_size.x, volume_size.y, volume_size.z);
+    vol_shader->SetUniform1i("axis", 3);
+    slice_rect->Draw();
+    vol_shader->Unbind();
+}
+
+/// <summary>
+/// Resample the oblique plane from the host copy of the volume (trilinear, at the finest voxel spacing)
+/// and save it as a PNG image
+/// </summary>
+void ExportOblique(glm::vec3 volume_size, std::string filename) {
+    VoxelGrid grid = VolumeGrid();
+    glm::vec3 dims((float)grid.X, (float)grid.Y, (float)grid.Z);
+
+    // world-space description of the plane
+    float diagonal = glm::length(volume_size);
+    glm::vec3 a = glm::vec3(oblique_rotation * glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+    glm::vec3 b = glm::vec3(oblique_rotation * glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
+    glm::vec3 n = glm::vec3(oblique_rotation * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+    glm::vec3 spacing = volume_size / dims;                                         // world size of a voxel along each axis
+    float pixel = std::min(spacing.x, std::min(spacing.y, spacing.z));
+    int size = std::min(4096, (int)std::ceil(diagonal / pixel));
+    pixel = diagonal / size;
+    glm::vec3 corner = n * gui_ObliqueOffset - a * (0.5f * diagonal) + b * (0.5f * diagonal);  // upper-left corner of the image
+
+    // convert to voxel coordinates: voxel = (world / volume_size + 0.5) * dims - 0.5
+    glm::vec3 origin = (corner / volume_size + glm::vec3(0.5f)) * dims - glm::vec3(0.5f);
+    glm::vec3 u = a * pixel / volume_size * dims;
+    glm::vec3 v = -b * pixel / volume_size * dims;
+
+    std::vector<unsigned char> slice((size_t)size * size * grid.C);
+    ReslicePlane(grid, origin, u, v, size, size, slice.data());
+
+    std::vector<unsigned char> rgba((size_t)size * size * 4);
+    for (size_t i = 0; i < (size_t)size * size; i++) {
+        for (size_t c = 0; c < 3; c++)
+            rgba[i * 4 + c] = slice[i * grid.C + std::min(c, grid.C - 1)];
+        rgba[i * 4 + 3] = (grid.C == 4) ? slice[i * grid.C + 3] : 255;
+    }
+    if (WritePNG(filename, rgba.data(), size, size, false))
+        std::cout << "Saved oblique slice (" << size << "x" << size << ") to " << filename << std::endl;
+}
+
+/// <summary>
+/// Renders one view (or all four quadrants) into the currently bound framebuffer
+/// </summary>
+/// <param name="view">ViewId of the view to render, VIEW_ALL renders the standard four-quadrant layout</param>
+/// <param name="width">Width of the render target in pixels</param>
+/// <param name="height">Height of the render target in pixels</param>
+/// <param name="volume_size">Volume sizes along each axis</param>
+/// <param name="plane_position">Position of each plane inside the volume [0, 1]</param>
+/// <param name="adaptive">If provided, the 3D view is rendered at reduced resolution while interacting and refined progressively otherwise</param>
+/// <param name="interacting">The camera or the oblique plane is being moved</param>
+/// <param name="changed">Something drawn in the 3D view changed since the last frame</param>
+void RenderViews(int view, int width, int height, glm::vec3 volume_size, glm::vec3 plane_position, glAdaptiveView* adaptive = nullptr, bool interacting = false, bool changed = true) {
+    float aspect = (float)width / (float)height;
+    glm::mat4 Mproj = createProjectionMatrix(aspect, volume_size);
+
+    int w = width, h = height;
+    if (view == VIEW_ALL) {
+        w = width / 2;
+        h = height / 2;
+    }
+
+    // render - Upper Right (X-Y) Viewport
+    if (view == VIEW_XY || view == VIEW_ALL) {
+        if (view == VIEW_ALL) glViewport(width / 2, height / 2, w, h);
+        else glViewport(0, 0, w, h);
+        RenderSlices(volume_size, plane_position, createViewMatrix(0, 1), Mproj, *slice_rect, *vol_shader);
+    }
+
+    // render - Lower Right (X-Z) Viewport
+    if (view == VIEW_XZ || view == VIEW_ALL) {
+        if (view == VIEW_ALL) glViewport(width / 2, 0, w, h);
+        else glViewport(0, 0, w, h);
+        RenderSlices(volume_size, plane_position, createViewMatrix(0, 2), Mproj, *slice_rect, *vol_shader);
+    }
+
+    // render - Lower Left (Y-Z) Viewport
+    if (view == VIEW_YZ || view == VIEW_ALL) {
+        glViewport(0, 0, w, h);
+        RenderSlices(volume_size, plane_position, createViewMatrix(1, 2), Mproj, *slice_rect, *vol_shader);
+    }
+
+    // Render the upper left (3D) view
+    if (view == VIEW_3D || view == VIEW_ALL) {
+        int y0 = (view == VIEW_ALL) ? height / 2 : 0;
+        bool draw = true;
+        glm::mat4 Pview3D = Mproj;
+        if (adaptive) {
+            draw = adaptive->Begin(0, y0, w, h, interacting, changed);                  // false once the refinement has converged
+            Pview3D = adaptive->Jitter() * Mproj;
+        }
+        else glViewport(0, y0, w, h);
+        glm::mat4 Mview3D = cam.viewmatrix(); // glm::lookat(cam.getPosition(), cam.getLookAt(), cam.getUp());
+        if (draw) {
+            RenderSlices(volume_size, plane_position, Mview3D, Pview3D, *slice_rect, *vol_shader);
+            if (gui_ObliqueEnable) RenderOblique(volume_size, Mview3D, Pview3D);
+            if (isosurface.visible) {
+                glm::vec3 light = glm::normalize(cam.getPosition() - cam.getLookAt());    // headlight
+                VoxelGrid shape = VolumeShape();
+                BindVolume();
+                isosurface.Draw(Pview3D * Mview3D, volume_size, glm::vec3((float)shape.X, (float)shape.Y, (float)shape.Z), light);
+            }
+        }
+        if (adaptive) adaptive->End();
+    }
+}
+
+/// <summary>
+/// Export the sweep described by sweep_settings, restoring the slice positions and camera afterwards
+/// </summary>
+void RunSweepExport(glm::vec3 volume_size) {
+    float saved_slice[3] = { gui_VolumeSlice[0], gui_VolumeSlice[1], gui_VolumeSlice[2] };
+    tira::camera saved_cam = cam;
+    float orbit_step = glm::radians(sweep_settings.orbit_degrees) / (float)std::max(1, sweep_settings.frames);
+
+    auto apply = [&](int i, float t) {
+        if (sweep_settings.mode == SWEEP_ORBIT) {
+            if (i > 0) cam.orbit(orbit_step, 0.0f);
+        }
+        else
+            gui_VolumeSlice[sweep_settings.mode] = t;
+    };
+    auto render = [&](int width, int height) {
+        glm::vec3 plane_position = glm::vec3(gui_VolumeSlice[0], gui_VolumeSlice[1], gui_VolumeSlice[2]);
+        RenderViews(sweep_settings.view, width, height, volume_size, plane_position);
+    };
+    ExportSweep(sweep_settings, apply, render);
+
+    for (int i = 0; i < 3; i++) gui_VolumeSlice[i] = saved_slice[i];
+    cam = saved_cam;
+}
+
 /// <summary>
 /// Load a volume from a NumPy file
 /// </summary>
@@ -480,7 +1119,45 @@ void inline RenderSlices(glm::vec3 volume_size, glm::vec3 plane_positions, glm::
 void LoadVolume(std::string filepath) {
     std::string extension = filepath.substr(filepath.find_last_of(".") + 1);    // get the file extension
     if (extension == "npy") {                                                   // make sure that the file extension indicates a NumPy file
-        vol->load_npy(filepath);                                                // load the file
+        // degrade to a downsampled volume rather than exceed the memory budget
+        int factor = gui_LoadDownsample;
+        DatasetInfo info;
+        if (ReadDatasetInfo(filepath, info)) {
+            UpdateMemoryUsage();
+            auto reduced = [&](int f) { return info.texture_bytes() / ((size_t)f * f * f); };
+            while (factor <= 8 && !memory.Reserve("Volume", reduced(factor), reduced(factor))) factor *= 2;
+            if (factor > 8) {
+                std::cout << "ERROR: " << filepath << " (" << FormatBytes(info.texture_bytes()) << ") does not fit in the memory budget ("
+                    << FormatBytes(memory.gpu_limit) << " GPU, " << FormatBytes(memory.host_limit) << " host) even when downsampled 8x" << std::endl;
+                return;
+            }
+            if (factor != gui_LoadDownsample)
+                std::cout << "WARNING: " << filepath << " (" << FormatBytes(info.texture_bytes()) << ") exceeds the memory budget, loading it downsampled "
+                    << factor << "x" << std::endl;
+        }
+
+        std::string source = filepath;
+        if (factor > 1) {                                                       // quick look: load a reduced copy, streamed from the file
+            source = DownsampledVolume(filepath, factor, memory.HostAvailable());     // the current volume stays resident meanwhile
+            if (source.empty()) return;
+        }
+        vol->load_npy(source);                                                  // load the file
+        demo.Release();
+        view3d.Restart();                                                       // the accumulated 3D view shows the previous data
+        vol_filename = source;                                                  // crops are exported from the data actually displayed
+        vol_source = filepath;
+        vol_downsample = (source != filepath) ? factor : 1;
+        ResetCrop();
+        BuildRanges();
+        isosurface.Reset();
+        LoadVolumeMetadata(filepath, vol_meta);                                 // read the voxel spacing from a sidecar (if present)
+        if (source != filepath) {                                               // a reduced voxel covers factor voxels along each axis
+            float f = (float)factor;
+            vol_meta.origin += 0.5f * (f - 1.0f) * vol_meta.spacing;
+            vol_meta.spacing *= f;
+        }
+        glm::vec3 default_size = DefaultVolumeSize();                           // scale the planes to the physical aspect ratio
+        for (int i = 0; i < 3; i++) gui_VolumeSize[i] = default_size[i];
     }
     else {
         std::cout << "ERROR: file type not supported (requires *.npy)" << std::endl;    // if the file is not a NumPy file, show an error and exit
@@ -488,55 +1165,351 @@ void LoadVolume(std::string filepath) {
     }
 }
 
+/// <summary>
+/// Load a NumPy file as an overlay that is composited over the primary volume
+/// </summary>
+/// <param name="filepath">NumPy file name</param>
+void LoadOverlay(std::string filepath) {
+    std::string extension = filepath.substr(filepath.find_last_of(".") + 1);
+    if (extension != "npy") {
+        std::cout << "ERROR: overlay file type not supported (requires *.npy)" << std::endl;
+        return;
+    }
+    std::string name = filepath.substr(filepath.find_last_of("/\\") + 1);
+    DatasetInfo info;                                                           // check the budget before reading the voxels
+    if (!ReadDatasetInfo(filepath, info)) {
+        std::cout << "ERROR: unable to read the NumPy header of " << filepath << std::endl;
+        return;
+    }
+    UpdateMemoryUsage();
+    if (!memory.Reserve("Overlays", overlays.Bytes() + info.texture_bytes(), info.texture_bytes())) {
+        std::cout << "ERROR: loading " << name << " (" << FormatBytes(info.texture_bytes()) << ") would exceed the memory budget of "
+            << FormatBytes(memory.gpu_limit) << std::endl;
+        return;
+    }
+
+    tira::volume<unsigned char> host;                                           // host copy is released once the texture is uploaded
+    host.load_npy(filepath);
+    VoxelGrid shape = VolumeShape();
+    if (host.X() != shape.X || host.Y() != shape.Y || host.Z() != shape.Z)
+        std::cout << "WARNING: overlay size differs from the primary volume, it will be stretched to fit" << std::endl;
+    if (overlays.Add(name, host.data(), host.X(), host.Y(), host.Z(), host.C())) {
+        overlays[overlays.size() - 1].path = filepath;
+        view3d.Restart();
+    }
+}
+
+/// <summary>
+/// Load an integer NumPy file as the label volume
+/// </summary>
+void LoadLabels(std::string filepath) {
+    UpdateMemoryUsage();
+    NpyHeader header;
+    if (ReadNpyHeader(filepath, header)) memory.Reserve("Labels", header.bytes(), 0);  // evict caches to make room if needed
+    size_t resident = memory.Gpu("Labels");
+    size_t budget = (memory.gpu_limit > resident) ? memory.gpu_limit - resident : 0;
+    if (!labels.Load(filepath, budget)) return;
+    labels_filename = filepath;
+    view3d.Restart();
+    std::cout << "Loaded " << labels.X << "x" << labels.Y << "x" << labels.Z << " label volume (" << 8 * labels.itemsize << "-bit)" << std::endl;
+}
+
+/// <summary>
+/// Label the connected components of the thresholded volume and show them as the label volume
+/// </summary>
+void RunComponents() {
+    VoxelGrid grid = VolumeGrid();
+    size_t channel = threshold.Channel(grid.C);                                 // the same channel the preview tests
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> ids;
+    components = LabelComponents(grid, channel, threshold.lo, threshold.hi, ids);
+    labels_filename.clear();                                                    // the labels shown from now on are computed
+    trace.Timing("labeled " + std::to_string(components.count) + " connected components (" + std::to_string(components.foreground) + " voxels)", start);
+
+    components_largest.resize(std::min<size_t>(10, components.count));
+    std::vector<uint32_t> order(components.count);
+    for (size_t i = 0; i < order.size(); i++) order[i] = (uint32_t)i + 1;
+    std::partial_sort(order.begin(), order.begin() + components_largest.size(), order.end(),
+        [&](uint32_t a, uint32_t b) { return components.sizes[a - 1] > components.sizes[b - 1]; });
+    std::copy(order.begin(), order.begin() + components_largest.size(), components_largest.begin());
+
+    // upload the ids as the label volume (16-bit when they fit), subject to the same budget as loaded labels
+    size_t itemsize = (components.count < 65536) ? 2 : 4;
+    UpdateMemoryUsage();
+    if (!memory.Reserve("Labels", ids.size() * itemsize, 0)) {
+        std::cout << "WARNING: component labels exceed the memory budget and will not be displayed" << std::endl;
+        return;
+    }
+    if (itemsize == 2) {
+        std::vector<uint16_t> ids16(ids.size());
+        parallel_for(ids.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) ids16[i] = (uint16_t)ids[i];
+        }, 1 << 20);
+        std::vector<uint32_t>().swap(ids);
+        labels.Set(ids16.data(), grid.X, grid.Y, grid.Z, 2);
+    }
+    else
+        labels.Set(ids.data(), grid.X, grid.Y, grid.Z, 4);
+    labels.visible = true;
+    view3d.Restart();
+}
+
+/// <summary>
+/// Capture the files that are open and the view as a session
+/// </summary>
+Session CurrentSession() {
+    Session s;
+    s.volume = vol_source;
+    s.downsample = session_pending ? session.downsample : vol_downsample;     // a preview is not the resolution the user chose
+    s.volume_size = glm::vec3(gui_VolumeSize[0], gui_VolumeSize[1], gui_VolumeSize[2]);
+    s.volume_slice = glm::vec3(gui_VolumeSlice[0], gui_VolumeSlice[1], gui_VolumeSlice[2]);
+    s.camera_position = cam.getPosition();
+    s.camera_lookat = cam.getLookAt();
+    s.camera_up = cam.getUp();
+    if (session_pending) s.overlays = session.overlays;                         // layers are loaded with the full volume
+    for (size_t i = 0; i < overlays.size(); i++) {
+        if (overlays[i].path.empty()) continue;
+        s.overlays.push_back({ overlays[i].path, overlays[i].colormap, overlays[i].blend, overlays[i].opacity, overlays[i].visible });
+    }
+    s.labels = session_pending ? session.labels : labels_filename;
+    s.labels_visible = labels.visible;
+    s.labels_outline = labels.outline;
+    s.labels_opacity = labels.opacity;
+    return s;
+}
+
+/// <summary>
+/// Save the session on exit. The volume is also written to the downsampled cache (from memory, so without reading
+/// the file again) to be shown immediately by the next restore.
+/// </summary>
+void SaveCurrentSession() {
+    if (!SaveSession(SESSION_FILE, CurrentSession())) return;
+    if (!vol_source.empty() && !session_pending && vol_downsample < SESSION_PREVIEW)
+        CacheDownsampledGrid(VolumeGrid(), vol_source, SESSION_PREVIEW);
+}
+
+/// <summary>
+/// Set the volume size, slices and camera of a session
+/// </summary>
+void ApplySessionView(const Session& s) {
+    for (int i = 0; i < 3; i++) {
+        gui_VolumeSize[i] = s.volume_size[i];
+        gui_VolumeSlice[i] = s.volume_slice[i];
+    }
+    cam.position(s.camera_position.x, s.camera_position.y, s.camera_position.z);
+    cam.lookat(s.camera_lookat.x, s.camera_lookat.y, s.camera_lookat.z, s.camera_up.x, s.camera_up.y, s.camera_up.z);
+}
+
+/// <summary>
+/// Replace the overlays and labels by those of the session
+/// </summary>
+void LoadSessionLayers(const Session& s) {
+    overlays.Clear();
+    for (const OverlaySession& o : s.overlays) {
+        size_t n = overlays.size();
+        LoadOverlay(o.path);
+        if (overlays.size() == n) continue;
+        overlays[n].colormap = o.colormap;
+        overlays[n].blend = o.blend;
+        overlays[n].opacity = o.opacity;
+        overlays[n].visible = o.visible;
+    }
+    labels.Clear();
+    labels_filename.clear();
+    if (!s.labels.empty()) LoadLabels(s.labels);
+    labels.visible = s.labels_visible;
+    labels.outline = s.labels_outline;
+    labels.opacity = s.labels_opacity;
+    view3d.Restart();                                                           // layers may have been removed or restyled
+}
+
+/// <summary>
+/// Restore the last session. If the downsampled copy of its volume is cached, that copy is displayed with the saved
+/// slices and camera first and the volume is loaded at its saved resolution after the next frame (FinishRestore),
+/// so a useful image is shown almost immediately even for large volumes.
+/// </summary>
+/// <returns>false if there is no session or its volume cannot be loaded</returns>
+bool BeginRestore() {
+    Session s;
+    if (!LoadSession(SESSION_FILE, s)) {
+        std::cout << "WARNING: no session to restore (" << SESSION_FILE << ")" << std::endl;
+        return false;
+    }
+    std::error_code ec;
+    if (!s.volume.empty() && !std::filesystem::exists(s.volume, ec)) {
+        std::cout << "ERROR: the volume of the last session (" << s.volume << ") no longer exists" << std::endl;
+        return false;
+    }
+    session = s;
+    session_pending = false;
+    if (!s.volume.empty()) {
+        std::string preview;
+        if (s.downsample < SESSION_PREVIEW) preview = CachedDownsampledVolume(s.volume, SESSION_PREVIEW);
+        gui_LoadDownsample = preview.empty() ? s.downsample : SESSION_PREVIEW;
+        LoadVolume(s.volume);
+        gui_LoadDownsample = s.downsample;
+        if (vol_source != s.volume) return false;                               // the volume could not be loaded
+        session_pending = !preview.empty();
+    }
+    ApplySessionView(s);
+    if (!session_pending) LoadSessionLayers(s);
+    return true;
+}
+
+/// <summary>
+/// Replace the preview shown by BeginRestore with the volume at its saved resolution, keeping the current view
+/// </summary>
+void FinishRestore() {
+    session_pending = false;
+    Session view = CurrentSession();
+    LoadVolume(session.volume);
+    ApplySessionView(view);
+    LoadSessionLayers(session);
+}
 
 int main(int argc, char** argv)
 {
+    // parse the command line: options start with "--", anything else is the volume to load
+    std::string in_filename;
+    bool bench_readback = false;                                                    // benchmark sync vs. async readback and exit
+    bool restore = false;                                                           // reopen the session saved on the last exit
+    bool fast_start = false;                                                        // overlap startup work on worker threads
+    bool purge_cache = false;                                                       // delete the cached thumbnails, downsampled volumes and shaders
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--bench-readback") bench_readback = true;
+        else if (arg == "--restore") restore = true;
+        else if (arg == "--trace-startup") trace.enabled = true;                   // print the duration of each phase of startup and of expensive operations
+        else if (arg == "--fast-start") fast_start = true;
+        else if (arg == "--purge-cache") purge_cache = true;
+        else if (arg == "--gpu-budget" && a + 1 < argc)                            // --gpu-budget MB : limit on the GPU memory of the viewer
+            memory.gpu_limit = (size_t)atoll(argv[++a]) << 20;
+        else if (arg == "--host-budget" && a + 1 < argc)                           // --host-budget MB : limit on the host memory of the viewer
+            memory.host_limit = (size_t)atoll(argv[++a]) << 20;
+        else if (arg == "--downsample" && a + 1 < argc) {                          // --downsample 2|4|8 : quick look at a reduced volume
+            gui_LoadDownsample = atoi(argv[++a]);
+            if (gui_LoadDownsample != 1 && gui_LoadDownsample != 2 && gui_LoadDownsample != 4 && gui_LoadDownsample != 8) {
+                std::cout << "WARNING: unsupported downsampling factor " << gui_LoadDownsample << " (use 2, 4 or 8), loading at full resolution" << std::endl;
+                gui_LoadDownsample = 1;
+            }
+        }
+        else in_filename = arg;
+    }
+    bool defer_load = fast_start && !bench_readback;                                // load the volume after the first frame
+    if (purge_cache) PurgeCache();
+    TrimCache("downsampled", CACHE_LIMIT_DOWNSAMPLED);                              // caches grow with every new dataset
+    TrimCache("thumbnails", CACHE_LIMIT_THUMBNAILS);
+    TrimCache("shaders", CACHE_LIMIT_SHADERS);
+    trace.Mark("command line");
+
     // Initialize OpenGL
     window = InitGLFW();                                                            // create a GLFW window
 
     glfwSetMouseButtonCallback(window, mouse_button_callback);                      // set mouse callback function
     glfwSetCursorPosCallback(window, cursor_position_callback);                     // set mouse movement callback function
+    double start_x, start_y;
+    glfwGetCursorPos(window, &start_x, &start_y);
+    input.Move(start_x, start_y);                                                   // start from the current cursor position
+    trace.Mark("window");
 
     InitUI(window, glsl_version);                                                   // initialize ImGui
-
+    trace.Mark("gui");
+
+    // fast start: build the font atlas (otherwise built in the first frame) and read the volume on worker threads
+    // while this thread, which owns the GL context, initializes GLEW and compiles the shaders
+    WorkerPool font_worker(1), io_worker(1);
+    double font_ms = 0.0, io_ms = 0.0;
+    if (fast_start) {
+        font_worker.submit([&] {
+            auto start = std::chrono::steady_clock::now();
+            ImGui::GetIO().Fonts->Build();
+            font_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        });
+    }
+    if (defer_load && !in_filename.empty()) {
+        io_worker.submit([&, factor = gui_LoadDownsample, host_budget = memory.HostAvailable()] {
+            auto start = std::chrono::steady_clock::now();
+            if (factor > 1) DownsampledVolume(in_filename, factor, host_budget);   // only the reduced copy is loaded
+            else PrefetchFile(in_filename);
+            io_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        });
+    }
 
     GLenum err = glewInit();                                                        // initialize GLEW
     if (GLEW_OK != err) {
         /* Problem: glewInit failed, something is seriously wrong. */
         fprintf(stderr, "Error: %s\n", glewGetErrorString(err));
     }
+    trace.Mark("glew");
 
-    // Load or create an example volume
+    // Load a volume, or show the demo volume (computed in the shader) until one is loaded
     vol = new tira::glVolume<unsigned char>();
-    if (argc > 1) {                                                                 // if any command line arguments are provided
-        std::string in_filename = argv[1];                                          // get the NPY file name
-        vol->load_npy(in_filename);
-    }
-    else {
-        vol->generate_rgb(256, 256, 256);                                           // generate an RGB grid texture
+    ResetCrop();
+    bool restored = false;
+    auto load_volume = [&] {
+        if (!in_filename.empty()) {                                                 // if a volume file is provided
+            LoadVolume(in_filename);
+        }
+        else if (restore) {
+            restored = BeginRestore();
+        }
+    };
+    if (!defer_load) {
+        load_volume();
+        trace.Mark("volume");
     }
 
 
     // generate the basic geometry and materials for rendering
-    tira::glGeometry rect = tira::glGeometry::GenerateRectangle<float>();           // create a rectangle for rendering volume cross-sections
-    vol_shader = new tira::glShader(SlicerVertexSource, SlicerFragmentSource);
-    vol->Bind();                                                                    // bind the volume texture so that the shader can use it
+    slice_rect = new tira::glGeometry();
+    *slice_rect = tira::glGeometry::GenerateRectangle<float>();                     // create a rectangle for rendering volume cross-sections
+    vol_shader = new glProgram(SlicerVertexSource, SlicerFragmentSource);
+    BindVolume();                                                                   // bind the volume texture so that the shader can use it
 
    // Create a new Cylinder object
     axis = new tira::glGeometry();
     *axis = tira::glGeometry::GenerateCylinder<float>(10, 20);
-    axis_shader = new tira::glShader(AxesVertexSource, AxesFragmentSource);
+    axis_shader = new glProgram(AxesVertexSource, AxesFragmentSource);
+    trace.Mark(std::string("shaders (") + ((vol_shader->Cached() && axis_shader->Cached()) ? "from the binary cache" : "compiled") + ") and geometry");
 
+    if (fast_start) {
+        font_worker.wait();                                                         // ImGui needs the atlas for the first frame
+        trace.Mark("font atlas (" + std::to_string((int)font_ms) + " ms on a worker)");
+    }
 
 
     // initialize the camera for 3D view
-    float vs_max = std::max(gui_VolumeSize[0], std::max(gui_VolumeSize[1], gui_VolumeSize[2]));         // find the maximum size of the volume
-    cam.position(2 * vs_max, 2 * vs_max, 2 * vs_max);                                                // eye
-    cam.lookat(0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);                                                     // center and up
+    float vs_max = FitCamera();
+    if (restored) ApplySessionView(session);
+
+    if (bench_readback) {
+        glm::vec3 volume_size = glm::vec3(gui_VolumeSize[0], gui_VolumeSize[1], gui_VolumeSize[2]);
+        glm::vec3 plane_position = glm::vec3(gui_VolumeSlice[0], gui_VolumeSlice[1], gui_VolumeSlice[2]);
+        auto render = [&](int width, int height) { RenderViews(VIEW_ALL, width, height, volume_size, plane_position); };
+        glEnable(GL_DEPTH_TEST);
+        double sync_fps = BenchmarkReadback(render, 1920, 1080, 300, false);
+        double async_fps = BenchmarkReadback(render, 1920, 1080, 300, true);
+        std::cout << "async / sync speedup: " << async_fps / sync_fps << std::endl;
+        return 0;
+    }
+
+    // screenshots are read back asynchronously and written to disk on a worker thread
+    WorkerPool screenshot_writer(1);
+    int screenshot_count = 0;
+    std::unique_ptr<glCapture> screenshot_capture = std::make_unique<glCapture>([&](int tag, const unsigned char* rgba, int width, int height) {
+        auto pixels = std::make_shared<std::vector<unsigned char>>(rgba, rgba + (size_t)width * height * 4);
+        screenshot_writer.submit([=] {
+            std::string filename = "screenshot_" + std::to_string(tag) + ".png";
+            if (WritePNG(filename, pixels->data(), width, height))
+                std::cout << "Saved " << filename << std::endl;
+        });
+    }, 2);
 
     int cnt;
     bool fileLoaded = false;
     bool fileLoaded1 = false;
+    bool first_frame = true;
 
     // Main event loop
     while (!glfwWindowShouldClose(window))
@@ -544,6 +1517,7 @@ int main(int argc, char** argv)
         // Poll and handle events (inputs, window resize, etc.)
         glfwPollEvents();
 
+        UpdateMemoryUsage();
         RenderUI();                                                         // render the user interface (the entire thing is rendered every frame)
         int display_w, display_h;                                           // size of the frame buffer (openGL display)
         glfwGetFramebufferSize(window, &display_w, &display_h);             // get the frame buffer size
@@ -553,18 +1527,26 @@ int main(int argc, char** argv)
 
 
         if (reset) resetPlane(vs_max);                                      // reset the axes
+        if (session_restore) BeginRestore();
 
         glm::vec3 volume_size = glm::vec3(gui_VolumeSize[0], gui_VolumeSize[1], gui_VolumeSize[2]);
         glm::vec3 plane_position = glm::vec3(gui_VolumeSlice[0], gui_VolumeSlice[1], gui_VolumeSlice[2]);
         glm::vec3 coordinates = glm::vec3(coords[0], coords[1], coords[2]);
 
 
-        // Projection Matrix
-        float aspect = (float)display_w / (float)display_h;
-        glm::mat4 Mproj = createProjectionMatrix(aspect, volume_size);
+        glEnable(GL_DEPTH_TEST);
 
+        if (oblique_reset) {
+            oblique_rotation = glm::mat4(1.0f);
+            gui_ObliqueOffset = 0.0f;
+        }
+        if (oblique_export) ExportOblique(volume_size, "oblique.png");
+
+        if (sweep_export) RunSweepExport(volume_size);                      // export an animated sweep (off-screen) if requested
+        if (crop_export) ExportCrop();                                      // write the subvolume inside the crop box
+        bool surface_changed = isosurface.visible && isosurface.Update(VolumeGrid(), vol_ranges);    // re-extracts only when the surface changes
+        if (components_run) RunComponents();                                // label connected components of the thresholded volume
 
-        glEnable(GL_DEPTH_TEST);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);                 // clear the Viewport using the clear color
 
 
@@ -572,44 +1554,110 @@ int main(int argc, char** argv)
         /*      Draw Stuff To The Viewport                  */
         /****************************************************/
 
-        glm::mat4 ViewMatrix(1.0f);
-
+        // apply the mouse events of this frame (the slices only move when a click or drag selects a new position);
         // coordination selection is not applied when user clicks on the imgui window
-        if (!window_focused)
-            coordinates_select(window, coordinates, display_w, display_h, volume_size, plane_position);
-
+        double select_x, select_y;
+        bool view_moved;
+        mouse.oblique_enable = gui_ObliqueEnable;
+        mouse.crop_enable = gui_CropEnable;
+        mouse.roi_tool = gui_RoiTool;
+        mouse.gui_focused = window_focused;
+        static const InputHandlers handlers = ViewHandlers();
+        bool selected = ProcessInput(mouse, input.Drain(), handlers, select_x, select_y, view_moved);
+        if (selected && !window_focused)
+            coordinates_select(select_x, select_y, coordinates, display_w, display_h, volume_size, plane_position);
+
+
+        // update the hover probe only when the cursor or the slices have moved
+        static double last_x = -1.0, last_y = -1.0;
+        static glm::vec3 last_plane(-1.0f), last_size(-1.0f);
+        double cursor_x = input.X(), cursor_y = input.Y();
+        if (!window_focused && (cursor_x != last_x || cursor_y != last_y || plane_position != last_plane || volume_size != last_size)) {
+            UpdateProbe(cursor_x, cursor_y, display_w, display_h, volume_size, plane_position);
+            last_x = cursor_x;
+            last_y = cursor_y;
+            last_plane = plane_position;
+            last_size = volume_size;
+        }
+
+        // recompute the measurement while it is being drawn (or when the slices move under it)
+        static float last_roi[4] = { -1.0f, -1.0f, -1.0f, -1.0f };
+        static int last_tool = 0, last_channel = 0;
+        static float last_depth = 0.0f;
+        static glm::vec3 last_roi_plane(-1.0f);
+        bool roi_changed = (last_tool != gui_RoiTool || last_channel != gui_RoiChannel || last_depth != gui_RoiDepth || plane_position != last_roi_plane);
+        for (int i = 0; i < 4; i++) roi_changed |= (mouse.roi_screen[i] != last_roi[i]);
+        if (gui_RoiTool != 0 && roi_changed) {
+            UpdateMeasurement(display_w, display_h, volume_size, plane_position);
+            for (int i = 0; i < 4; i++) last_roi[i] = mouse.roi_screen[i];
+            last_tool = gui_RoiTool;
+            last_channel = gui_RoiChannel;
+            last_depth = gui_RoiDepth;
+            last_roi_plane = plane_position;
+        }
+
+        if (gui_CropEnable) UpdateCropBox(display_w, display_h, volume_size);
 
         // Sets global varilabes (gui_VolumeSlice and coords) to the updated values and view on imgui window
         SetGlobalVariables(plane_position, coordinates);
-
+        glm::vec3 physical = PhysicalPosition(coordinates, volume_size);
+        for (int i = 0; i < 3; i++) coords_physical[i] = physical[i];
+
+
+        // the 3D view is interactive until the camera has been still for a moment (the next frame is full resolution)
+        static auto last_motion = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+        if (view_moved) last_motion = std::chrono::steady_clock::now();
+        bool interacting = (std::chrono::steady_clock::now() - last_motion) < std::chrono::milliseconds(100);
+
+        // restart the progressive refinement of the 3D view whenever what it shows may have changed: any click or GUI
+        // edit, a new slice position, volume size or window size, or a new isosurface
+        static glm::vec3 last_view_plane(-1.0f), last_view_size(-1.0f);
+        static int last_view_w = 0, last_view_h = 0;
+        bool view_changed = interacting || selected || surface_changed || ImGui::IsAnyItemActive() ||
+                            ImGui::IsMouseDown(0) || ImGui::IsMouseDown(1) || ImGui::IsMouseReleased(0) ||
+                            plane_position != last_view_plane || volume_size != last_view_size || display_w != last_view_w || display_h != last_view_h;
+        last_view_plane = plane_position;
+        last_view_size = volume_size;
+        last_view_w = display_w;
+        last_view_h = display_h;
 
         // Bind the volume material and render all of the viewports
+        RenderViews(VIEW_ALL, display_w, display_h, volume_size, plane_position, &view3d, interacting, view_changed);
 
-        // render - Upper Right (X-Y) Viewport
-        glViewport(display_w / 2, display_h / 2, display_w / 2, display_h / 2);
-        ViewMatrix = createViewMatrix(0, 1);
-        RenderSlices(volume_size, plane_position, ViewMatrix, Mproj, rect, *vol_shader);
-
-        // render - Lower Right (X-Z) Viewport
-        glViewport(display_w / 2, 0, display_w / 2, display_h / 2);
-        ViewMatrix = createViewMatrix(0, 2);
-        RenderSlices(volume_size, plane_position, ViewMatrix, Mproj, rect, *vol_shader);
-
-        // render - Lower Left (Y-Z) Viewport
-        glViewport(0, 0, display_w / 2, display_h / 2);
-        ViewMatrix = createViewMatrix(1, 2);
-        RenderSlices(volume_size, plane_position, ViewMatrix, Mproj, rect, *vol_shader);
-
-        // Render the upper left (3D) view
-        glViewport(0, display_h / 2, display_w / 2, display_h / 2);
-        glm::mat4 Mview3D = cam.viewmatrix(); // glm::lookat(cam.getPosition(), cam.getLookAt(), cam.getUp());
-        RenderSlices(volume_size, plane_position, Mview3D, Mproj, rect, *vol_shader);
-
+        if (screenshot)                                                     // read back the viewports (without the GUI)
+            screenshot_capture->Capture(0, 0, display_w, display_h, screenshot_count++);
+        screenshot_capture->Poll();
 
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());     // draw the GUI data from its buffer
         glfwSwapBuffers(window);                                    // swap the double buffer
+
+        if (session_pending) FinishRestore();                       // the preview has been presented, load the full volume
+
+        if (first_frame) {
+            first_frame = false;
+            trace.Mark("first frame");
+            if (defer_load) {                                       // fast start: the volume is loaded once the window is up
+                io_worker.wait();
+                if (!in_filename.empty()) trace.Mark("volume read (" + std::to_string((int)io_ms) + " ms on a worker)");
+                load_volume();
+                vs_max = FitCamera();                               // the camera was placed for the default volume size
+                if (restored) ApplySessionView(session);
+                trace.Mark("volume");
+            }
+        }
     }
 
+    SaveCurrentSession();
+
+    screenshot_capture.reset();                                     // finish any pending screenshots and release the PBOs and fences
+    screenshot_writer.wait();
+    picker.Destroy();                                               // release GL resources while the context still exists
+    isosurface.Destroy();
+    view3d.Destroy();
+    vol_ranges.Destroy();
+    demo.Release();
+    labels.Clear();
+    overlays.Clear();
     ImGuiFileDialog::Instance()->Close();
 
     DestroyUI();                                                    // Clear the ImGui user interface
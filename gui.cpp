@@ -1,4 +1,18 @@
 #include "gui.h"
+#include "sweep.h"
+#include "metadata.h"
+#include "overlay.h"
+#include "labels.h"
+#include "probe.h"
+#include "roi.h"
+#include "crop.h"
+#include "segment.h"
+#include "isosurface.h"
+#include "adaptive.h"
+#include "thumbnail.h"
+#include "dataset.h"
+#include "budget.h"
+#include "input.h"
 
 #include <iostream>
 
@@ -12,10 +26,47 @@ bool rgb_file = false;
 extern float gui_VolumeSize[];
 extern float gui_VolumeSlice[];
 extern float coords[];
+extern float coords_physical[];
+extern VolumeMetadata vol_meta;
+extern OverlayStack overlays;
+extern LabelVolume labels;
+extern ProbeResult probe;
+extern int gui_RoiTool;
+extern float gui_RoiDepth;
+extern int gui_RoiChannel;
+extern InputState mouse;
+extern std::vector<float> roi_profile;
+extern RoiStats roi_stats;
+extern ThresholdPreview threshold;
+extern ComponentStats components;
+extern std::vector<uint32_t> components_largest;
+extern bool components_run;
+extern glIsosurface isosurface;
+extern glAdaptiveView view3d;
+extern MemoryBudget memory;
+extern bool gui_CropEnable;
+extern int gui_LoadDownsample;
+extern int gui_CropLo[];
+extern int gui_CropHi[];
+extern int crop_dims[];
+extern int gui_CropFormat;
+extern bool crop_export;
+extern float crop_screen[];
 extern bool window_focused;
+extern bool gui_ObliqueEnable;
+extern float gui_ObliqueOffset;
+extern bool oblique_reset;
+extern bool oblique_export;
 bool button_click = false;
+extern SweepSettings sweep_settings;
+extern bool sweep_export;
+extern bool screenshot;
+extern bool session_restore;
 
 void LoadVolume(std::string filepath);
+void LoadOverlay(std::string filepath);
+void LoadLabels(std::string filepath);
+VoxelGrid VolumeShape();
 
 
 void glfw_error_callback(int error, const char* description)
@@ -67,6 +118,104 @@ void InitUI(GLFWwindow* window, const char* glsl_version) {
     // Load Fonts
     io.Fonts->AddFontFromFileTTF("Roboto-Medium.ttf", ui_scale * 16.0f);
 
+    // File dialog thumbnails: volumes are previewed by their centre slice (in the dialog's thumbnail thread), the
+    // textures are created and destroyed here on the GL thread
+    ImGuiFileDialog::Instance()->AddThumbnailExtractor(".npy", [](const std::string& path, int height, IGFD_Thumbnail_Info* info) {
+        VolumeThumbnail thumbnail;
+        if (!MakeVolumeThumbnail(path, (int)(height * ui_scale), thumbnail)) return false;
+        info->textureFileDatas = new unsigned char[thumbnail.rgba.size()];
+        std::copy(thumbnail.rgba.begin(), thumbnail.rgba.end(), info->textureFileDatas);
+        info->textureWidth = thumbnail.width;
+        info->textureHeight = thumbnail.height;
+        info->textureChannels = 4;
+        return true;
+    });
+    ImGuiFileDialog::Instance()->SetCreateThumbnailCallback([](IGFD_Thumbnail_Info* info) {
+        if (!info || !info->isReadyToUpload || !info->textureFileDatas) return;
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, info->textureWidth, info->textureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, info->textureFileDatas);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        info->textureID = (void*)(intptr_t)texture;
+
+        delete[] info->textureFileDatas;
+        info->textureFileDatas = nullptr;
+        info->isReadyToUpload = false;
+        info->isReadyToDisplay = true;
+    });
+    ImGuiFileDialog::Instance()->SetDestroyThumbnailCallback([](IGFD_Thumbnail_Info* info) {
+        if (!info) return;
+        GLuint texture = (GLuint)(intptr_t)info->textureID;
+        glDeleteTextures(1, &texture);
+    });
+}
+
+/// <summary>
+/// Side pane of the volume file dialogs: describes the selected file from its NumPy header (the voxels are not read)
+/// and warns if it would not fit in the GPU memory budget
+/// </summary>
+/// <param name="user_data">Optional pointer to the load downsampling factor (int), adds the quick look options</param>
+static void DatasetPane(const char* filter, IGFD::UserDatas user_data, bool* can_continue) {
+    int* downsample = (int*)user_data;
+    static std::string path;                                                    // the header is only read when the selection changes
+    static DatasetInfo info;
+    static bool valid = false;
+    std::string selected = ImGuiFileDialog::Instance()->GetFilePathName();
+    if (selected != path) {
+        path = selected;
+        valid = ReadDatasetInfo(path, info);
+    }
+    if (downsample) {
+        bool quick_look = (*downsample > 1);
+        if (ImGui::Checkbox("Quick Look (downsample)", &quick_look)) *downsample = quick_look ? 2 : 1;
+        if (quick_look) {
+            const char* factors[] = { "2x", "4x", "8x" };
+            int f = (*downsample >= 8) ? 2 : (*downsample >= 4) ? 1 : 0;
+            if (ImGui::Combo("Factor", &f, factors, 3)) *downsample = 2 << f;
+        }
+        ImGui::Separator();
+    }
+    if (!valid) {
+        ImGui::TextWrapped("Select a NumPy volume to preview its header");
+        return;
+    }
+
+    ImGui::Text("Dimensions: %zu x %zu x %zu", info.X, info.Y, info.Z);
+    ImGui::Text("Channels: %zu", info.C);
+    ImGui::Text("Type: %s%s", DatasetTypeName(info.header).c_str(), info.header.fortran_order ? " (Fortran order)" : "");
+    ImGui::Text("Voxels: %.3g", (double)info.voxels());
+    if (info.meta.loaded)
+        ImGui::Text("Spacing: %g x %g x %g %s", info.meta.spacing.x, info.meta.spacing.y, info.meta.spacing.z, info.meta.units.c_str());
+    else
+        ImGui::TextDisabled("Spacing: no sidecar (1 x 1 x 1)");
+    ImGui::Text("File: %s", FormatBytes(info.file_bytes).c_str());
+    if (!info.complete)
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "The file is truncated");
+
+    ImGui::Separator();
+    size_t resident = downsample ? memory.Gpu("Volume") : memory.Gpu();        // a new primary volume replaces the current one
+    size_t available = (memory.gpu_limit > resident) ? memory.gpu_limit - resident : 0;
+    size_t f = downsample ? (size_t)*downsample : 1;
+    size_t bytes = info.texture_bytes() / (f * f * f);
+    ImGui::Text("GPU memory: %s", FormatBytes(bytes).c_str());
+    ImGui::Text("Available: %s", FormatBytes(available).c_str());
+    if (bytes > available) {
+        ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "Exceeds the GPU memory budget");
+        int factor = FitDownsampling(info.texture_bytes(), available);
+        if (factor > 0) {
+            ImGui::TextWrapped("Downsampled %dx it would fit (%s)", factor, FormatBytes(info.texture_bytes() / ((size_t)factor * factor * factor)).c_str());
+            if (downsample && ImGui::Button("Use Quick Look")) *downsample = factor;
+        }
+        else
+            ImGui::TextWrapped("It does not fit even when downsampled 8x");
+    }
 }
 
 /// <summary>
@@ -74,6 +223,7 @@ void InitUI(GLFWwindow* window, const char* glsl_version) {
 /// </summary>
 void DestroyUI() {
     // Cleanup
+    ImGuiFileDialog::Instance()->ManageGPUThumbnails();                         // release the thumbnails of the closed dialogs
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -113,8 +263,10 @@ void RenderUI() {
         //Opens File Dialog        
         if (ImGui::Button("Open File Dialog"))
         {
-            ImGuiFileDialog::Instance()->OpenDialog("ChooseFileDlgKey", "Choose File", ".npy,.bmp,.cpp,.h,.hpp", ".");
+            ImGuiFileDialog::Instance()->OpenDialog("ChooseFileDlgKey", "Choose File", ".npy,.bmp,.cpp,.h,.hpp", ".", "", DatasetPane, 300.0f * ui_scale, 1, &gui_LoadDownsample);
         }
+        ImGui::SameLine();
+        session_restore = ImGui::Button("Restore Last Session");
 
         if (ImGuiFileDialog::Instance()->Display("ChooseFileDlgKey"))
         {
@@ -139,34 +291,278 @@ void RenderUI() {
         ImGui::Text("\t\tZ");
         ImGui::PopStyleColor(3);
         ImGui::SliderFloat3("Volume Size", gui_VolumeSize, 0.25f, 2.0f);
+        ImGui::Text("Voxel Spacing: %g x %g x %g %s", vol_meta.spacing.x, vol_meta.spacing.y, vol_meta.spacing.z, vol_meta.units.c_str());
         ImGui::SliderFloat3("Volume Slice", gui_VolumeSlice, 0.0f, 1.0f);
         ImGui::Spacing();
         reset = ImGui::Button("Reset", ImVec2(70, 35));
+        ImGui::SameLine();
+        screenshot = ImGui::Button("Screenshot", ImVec2(130, 35));
         ImGui::Spacing();
 
-        if (ImGui::BeginTable("Coordinates", 2, ImGuiTableFlags_Resizable + ImGuiTableFlags_Borders, ImVec2(0.0f, 5.0f), 2.0f))
+        if (ImGui::BeginTable("Coordinates", 3, ImGuiTableFlags_Resizable + ImGuiTableFlags_Borders, ImVec2(0.0f, 5.0f), 2.0f))
         {
+            const char* axes[] = { "X", "Y", "Z" };
+            std::string physical_header = "Physical (" + vol_meta.units + ")";
             ImGui::TableSetupColumn("Axis");
             ImGui::TableSetupColumn("Value");
+            ImGui::TableSetupColumn(physical_header.c_str());
             ImGui::TableHeadersRow();
-            ImGui::TableNextRow();
-            ImGui::TableNextColumn();
-            ImGui::Text("X");
-            ImGui::TableNextColumn();
-            ImGui::Text("%f", coords[0]);
-            ImGui::TableNextRow();
-            ImGui::TableNextColumn();
-            ImGui::Text("Y");
-            ImGui::TableNextColumn();
-            ImGui::Text("%f", coords[1]);
-            ImGui::TableNextRow();
-            ImGui::TableNextColumn();
-            ImGui::Text("Z");
-            ImGui::TableNextColumn();
-            ImGui::Text("%f", coords[2]);
+            for (int i = 0; i < 3; i++) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", axes[i]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%f", coords[i]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%f", coords_physical[i]);
+            }
             ImGui::EndTable();
         }
 
+        // Additional volumes composited over the primary volume
+        if (ImGui::CollapsingHeader("Overlays")) {
+            if (ImGui::Button("Add Overlay"))
+                ImGuiFileDialog::Instance()->OpenDialog("ChooseOverlayDlgKey", "Choose Overlay", ".npy", ".", "", DatasetPane, 300.0f * ui_scale);
+
+            const char* colormaps[] = { "Native", "Red", "Green", "Blue", "Magenta", "Hot" };
+            const char* blends[] = { "Alpha", "Add", "Max" };
+            int remove = -1;
+            for (size_t i = 0; i < overlays.size(); i++) {
+                OverlayLayer& layer = overlays[i];
+                ImGui::PushID((int)i);
+                ImGui::Separator();
+                bool edited = ImGui::Checkbox(layer.name.c_str(), &layer.visible);
+                ImGui::SameLine();
+                if (ImGui::Button("Remove")) remove = (int)i;
+                edited |= ImGui::Combo("Colormap", &layer.colormap, colormaps, 6);
+                edited |= ImGui::Combo("Blend", &layer.blend, blends, 3);
+                edited |= ImGui::SliderFloat("Opacity", &layer.opacity, 0.0f, 1.0f);
+                if (edited) view3d.Restart();                   // the accumulated 3D view shows the previous look
+                ImGui::PopID();
+            }
+            if (remove >= 0) {
+                overlays.Remove(remove);
+                view3d.Restart();
+            }
+            ImGui::Text("Overlay memory: %zu MB", overlays.Bytes() / (1024 * 1024));
+        }
+
+        if (ImGuiFileDialog::Instance()->Display("ChooseOverlayDlgKey"))
+        {
+            if (ImGuiFileDialog::Instance()->IsOk())
+                LoadOverlay(ImGuiFileDialog::Instance()->GetFilePathName());
+            ImGuiFileDialog::Instance()->Close();
+        }
+
+        // Integer label volume (segmentation)
+        if (ImGui::CollapsingHeader("Labels")) {
+            if (ImGui::Button("Load Labels"))
+                ImGuiFileDialog::Instance()->OpenDialog("ChooseLabelsDlgKey", "Choose Label Volume", ".npy", ".", "", DatasetPane, 300.0f * ui_scale);
+            if (labels.Loaded()) {
+                ImGui::SameLine();
+                bool edited = false;
+                if (ImGui::Button("Clear Labels")) {
+                    labels.Clear();
+                    edited = true;
+                }
+                edited |= ImGui::Checkbox("Show Labels", &labels.visible);
+                ImGui::SameLine();
+                edited |= ImGui::Checkbox("Outline", &labels.outline);
+                edited |= ImGui::SliderFloat("Label Opacity", &labels.opacity, 0.0f, 1.0f);
+                if (edited) view3d.Restart();
+            }
+        }
+
+        if (ImGuiFileDialog::Instance()->Display("ChooseLabelsDlgKey"))
+        {
+            if (ImGuiFileDialog::Instance()->IsOk())
+                LoadLabels(ImGuiFileDialog::Instance()->GetFilePathName());
+            ImGuiFileDialog::Instance()->Close();
+        }
+
+        // Threshold preview and connected components (the result replaces the label volume)
+        if (ImGui::CollapsingHeader("Segmentation")) {
+            bool edited = ImGui::Checkbox("Threshold Preview", &threshold.enable);
+            edited |= ImGui::DragIntRange2("Threshold", &threshold.lo, &threshold.hi, 1.0f, 0, 255);
+            size_t channels = VolumeShape().C;
+            threshold.channel = (int)threshold.Channel(channels);       // keep the selection valid for the current volume
+            int max_channel = (int)std::min<size_t>(channels, 4) - 1;
+            if (max_channel > 0)
+                edited |= ImGui::SliderInt("Threshold Channel", &threshold.channel, 0, max_channel);
+            edited |= ImGui::SliderFloat("Threshold Opacity", &threshold.opacity, 0.0f, 1.0f);
+            if (edited) view3d.Restart();
+            components_run = ImGui::Button("Label Components", ImVec2(160, 35));
+            if (components.count > 0) {
+                float voxel_volume = vol_meta.spacing.x * vol_meta.spacing.y * vol_meta.spacing.z;
+                ImGui::Text("Components: %zu", components.count);
+                ImGui::Text("Foreground: %llu voxels", (unsigned long long)components.foreground);
+                if (ImGui::BeginTable("components", 3)) {
+                    ImGui::TableSetupColumn("Label");
+                    ImGui::TableSetupColumn("Voxels");
+                    ImGui::TableSetupColumn("Volume");
+                    ImGui::TableHeadersRow();
+                    for (uint32_t id : components_largest) {
+                        uint64_t size = components.sizes[id - 1];
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%u", id);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%llu", (unsigned long long)size);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%g %s^3", size * voxel_volume, vol_meta.units.c_str());
+                    }
+                    ImGui::EndTable();
+                }
+            }
+        }
+        else
+            components_run = false;
+
+        // Isosurface drawn in the 3D view
+        if (ImGui::CollapsingHeader("Isosurface")) {
+            bool edited = ImGui::Checkbox("Show Isosurface", &isosurface.visible);
+            edited |= ImGui::SliderFloat("Iso-Value", &isosurface.iso, 0.0f, 255.0f);
+            edited |= ImGui::InputInt("Iso Channel", &isosurface.channel);
+            edited |= ImGui::ColorEdit3("Surface Color", &isosurface.color[0]);
+            if (edited) view3d.Restart();
+            if (isosurface.visible)
+                ImGui::Text("%zu triangles (%zu bricks in %.1f ms)", isosurface.Triangles(), isosurface.last_bricks, isosurface.last_ms);
+        }
+
+        // Resolution of the 3D view while the camera is moving and its refinement while it is still
+        if (ImGui::CollapsingHeader("Rendering")) {
+            ImGui::Checkbox("Adaptive Resolution", &view3d.enable);
+            ImGui::SliderFloat("Frame Budget (ms)", &view3d.target_ms, 2.0f, 50.0f);
+            ImGui::SliderFloat("Minimum Scale", &view3d.min_scale, 0.125f, 1.0f);
+            ImGui::Checkbox("Progressive Refinement", &view3d.progressive);
+            ImGui::SliderInt("Refinement Samples", &view3d.max_samples, 1, 64);
+            ImGui::Text("3D view: %.1f ms at full resolution, scale %.3f", view3d.FullResMs(), view3d.Scale());
+            ImGui::Text("Refinement: %d / %d samples%s", view3d.Samples(), view3d.max_samples, view3d.Converged() ? " (converged)" : "");
+        }
+
+        // Footprint of the resident resources and the limits enforced when loading data
+        if (ImGui::CollapsingHeader("Memory")) {
+            int gpu_mb = (int)(memory.gpu_limit >> 20);
+            int host_mb = (int)(memory.host_limit >> 20);
+            if (ImGui::InputInt("GPU Budget (MB)", &gpu_mb, 256, 1024)) memory.gpu_limit = (size_t)std::max(gpu_mb, 256) << 20;
+            if (ImGui::InputInt("Host Budget (MB)", &host_mb, 256, 1024)) memory.host_limit = (size_t)std::max(host_mb, 256) << 20;
+            ImGui::Text("GPU: %s / %s", FormatBytes(memory.Gpu()).c_str(), FormatBytes(memory.gpu_limit).c_str());
+            ImGui::Text("Host: %s / %s", FormatBytes(memory.Host()).c_str(), FormatBytes(memory.host_limit).c_str());
+            if (memory.device_total > 0)
+                ImGui::Text("Device: %s available of %s", FormatBytes(memory.device_available).c_str(), FormatBytes(memory.device_total).c_str());
+            else if (memory.device_available > 0)
+                ImGui::Text("Device: %s available", FormatBytes(memory.device_available).c_str());
+            if (ImGui::BeginTable("memory", 3, ImGuiTableFlags_Borders)) {
+                for (const MemoryEntry& e : memory.Entries()) {
+                    if (e.gpu + e.host == 0) continue;
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", e.name.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", FormatBytes(e.gpu).c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", FormatBytes(e.host).c_str());
+                }
+                ImGui::EndTable();
+            }
+        }
+
+        // User-defined oblique plane (rotated with shift + left drag in the 3D view)
+        if (ImGui::CollapsingHeader("Oblique Plane")) {
+            ImGui::Checkbox("Show Oblique Plane", &gui_ObliqueEnable);
+            ImGui::SliderFloat("Offset", &gui_ObliqueOffset, -1.0f, 1.0f);
+            oblique_reset = ImGui::Button("Reset Plane", ImVec2(140, 35));
+            ImGui::SameLine();
+            oblique_export = ImGui::Button("Export Plane", ImVec2(140, 35));
+        }
+        else {
+            oblique_reset = false;
+            oblique_export = false;
+        }
+
+        // Export an animated sweep through the volume (or an orbit around it)
+        if (ImGui::CollapsingHeader("Sweep Export")) {
+            const char* modes[] = { "X Slice", "Y Slice", "Z Slice", "Orbit" };
+            const char* views[] = { "3D", "X-Y", "X-Z", "Y-Z", "All" };
+            const char* formats[] = { "PNG", "Raw", "Y4M" };
+            static char prefix[256] = "sweep";
+            ImGui::Combo("Animate", &sweep_settings.mode, modes, 4);
+            ImGui::Combo("View", &sweep_settings.view, views, 5);
+            ImGui::Combo("Format", &sweep_settings.format, formats, 3);
+            ImGui::InputInt("Frames", &sweep_settings.frames);
+            ImGui::InputInt("Width", &sweep_settings.width);
+            ImGui::InputInt("Height", &sweep_settings.height);
+            if (sweep_settings.mode == SWEEP_ORBIT)
+                ImGui::SliderFloat("Degrees", &sweep_settings.orbit_degrees, 0.0f, 360.0f);
+            ImGui::Checkbox("Asynchronous readback", &sweep_settings.async_readback);
+            ImGui::InputText("Prefix", prefix, sizeof(prefix));
+            sweep_settings.prefix = prefix;
+            sweep_export = ImGui::Button("Export", ImVec2(90, 35));
+        }
+        else
+            sweep_export = false;
+
+        // Values under the mouse cursor
+        if (ImGui::CollapsingHeader("Probe", ImGuiTreeNodeFlags_DefaultOpen)) {
+            if (probe.valid) {
+                ImGui::Text("Voxel: (%d, %d, %d)", probe.voxel.x, probe.voxel.y, probe.voxel.z);
+                ImGui::Text("Position: (%g, %g, %g) %s", probe.physical.x, probe.physical.y, probe.physical.z, vol_meta.units.c_str());
+                if (probe.channels == 1) ImGui::Text("Value: %g", probe.value[0]);
+                else if (probe.channels == 2) ImGui::Text("Value: (%g, %g)", probe.value[0], probe.value[1]);
+                else if (probe.channels == 3) ImGui::Text("Value: (%g, %g, %g)", probe.value[0], probe.value[1], probe.value[2]);
+                else ImGui::Text("Value: (%g, %g, %g, %g)", probe.value[0], probe.value[1], probe.value[2], probe.value[3]);
+                if (probe.has_label) ImGui::Text("Label: %u", probe.label);
+                for (size_t i = 0; i < probe.overlay_count && i < overlays.size(); i++) {
+                    const unsigned int* o = probe.overlay[i];
+                    if (overlays[i].C == 1) ImGui::Text("%s: %u", overlays[i].name.c_str(), o[0]);
+                    else ImGui::Text("%s: (%u, %u, %u, %u)", overlays[i].name.c_str(), o[0], o[1], o[2], o[3]);
+                }
+            }
+            else
+                ImGui::Text("Move the cursor over a slice");
+        }
+
+        // Crop box and subvolume export
+        if (ImGui::CollapsingHeader("Crop")) {
+            ImGui::Checkbox("Show Crop Box (ctrl + drag a face in 3D)", &gui_CropEnable);
+            ImGui::DragIntRange2("X Range", &gui_CropLo[0], &gui_CropHi[0], 1.0f, 0, crop_dims[0] - 1);
+            ImGui::DragIntRange2("Y Range", &gui_CropLo[1], &gui_CropHi[1], 1.0f, 0, crop_dims[1] - 1);
+            ImGui::DragIntRange2("Z Range", &gui_CropLo[2], &gui_CropHi[2], 1.0f, 0, crop_dims[2] - 1);
+            if (ImGui::Button("Whole Volume")) {
+                for (int i = 0; i < 3; i++) {
+                    gui_CropLo[i] = 0;
+                    gui_CropHi[i] = crop_dims[i] - 1;
+                }
+            }
+            const char* formats[] = { "NumPy (*.npy)", "Raw" };
+            ImGui::Combo("File Format", &gui_CropFormat, formats, 2);
+            crop_export = ImGui::Button("Export Subvolume", ImVec2(160, 35));
+        }
+        else
+            crop_export = false;
+
+        // Line profiles and ROI statistics (drawn with a left drag in the 2D views)
+        if (ImGui::CollapsingHeader("Measure")) {
+            ImGui::RadioButton("Off", &gui_RoiTool, 0);
+            ImGui::SameLine();
+            ImGui::RadioButton("Line", &gui_RoiTool, 1);
+            ImGui::SameLine();
+            ImGui::RadioButton("Box", &gui_RoiTool, 2);
+            ImGui::SameLine();
+            ImGui::RadioButton("Sphere", &gui_RoiTool, 3);
+            ImGui::InputInt("Channel", &gui_RoiChannel);
+            if (gui_RoiTool == 2) ImGui::SliderFloat("Depth (voxels)", &gui_RoiDepth, 1.0f, 512.0f);
+
+            if (gui_RoiTool == 1 && !roi_profile.empty())
+                ImGui::PlotLines("Profile", roi_profile.data(), (int)roi_profile.size(), 0, NULL, 0.0f, 255.0f, ImVec2(0, 120));
+            if (gui_RoiTool >= 2 && roi_stats.count > 0) {
+                ImGui::Text("Voxels: %llu", (unsigned long long)roi_stats.count);
+                ImGui::Text("Mean: %.3f  Std: %.3f", roi_stats.mean, roi_stats.stddev);
+                ImGui::Text("Min: %d  Max: %d", roi_stats.min, roi_stats.max);
+                ImGui::PlotLines("Mean / Slice", roi_stats.slice_mean.data(), (int)roi_stats.slice_mean.size(), 0, NULL, 0.0f, 255.0f, ImVec2(0, 120));
+            }
+        }
+
         ImGui::GetFont()->Scale = old_size;
         ImGui::PopFont();
         ImGui::End();
@@ -178,7 +574,35 @@ void RenderUI() {
 
 
 
+    // draw the edges of the crop box over the 3D view (corner c has x, y, z from bits 0, 1, 2 of c)
+    if (gui_CropEnable) {
+        ImDrawList* draw = ImGui::GetForegroundDrawList();
+        for (int c = 0; c < 8; c++) {
+            for (int bit = 1; bit < 8; bit <<= 1) {
+                if (c & bit) continue;
+                ImVec2 p0(crop_screen[2 * c], crop_screen[2 * c + 1]);
+                ImVec2 p1(crop_screen[2 * (c | bit)], crop_screen[2 * (c | bit) + 1]);
+                draw->AddLine(p0, p1, IM_COL32(0, 255, 255, 255), 1.5f);
+            }
+        }
+    }
+
+    // draw the current measurement over the 2D views
+    const float* roi_screen = mouse.roi_screen;
+    if (gui_RoiTool != 0 && (roi_screen[0] != roi_screen[2] || roi_screen[1] != roi_screen[3])) {
+        ImDrawList* draw = ImGui::GetForegroundDrawList();
+        ImVec2 p0(roi_screen[0], roi_screen[1]), p1(roi_screen[2], roi_screen[3]);
+        ImU32 color = IM_COL32(255, 255, 0, 255);
+        if (gui_RoiTool == 1) draw->AddLine(p0, p1, color, 2.0f);
+        else if (gui_RoiTool == 2) draw->AddRect(p0, p1, color, 0.0f, 0, 2.0f);
+        else {
+            float dx = p1.x - p0.x, dy = p1.y - p0.y;
+            draw->AddCircle(p0, sqrtf(dx * dx + dy * dy), color, 64, 2.0f);
+        }
+    }
+
     //ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);  // Render a separate window showing the FPS
 
+    ImGuiFileDialog::Instance()->ManageGPUThumbnails();                         // upload (or release) file dialog thumbnails
     ImGui::Render();                                                            // Render all windows
 }
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "imagewriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static uint32_t crc_table[256];
+static std::once_flag crc_once;
+
+static void build_crc_table() {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+}
+
+static uint32_t crc32(uint32_t crc, const unsigned char* buf, size_t len) {
+    std::call_once(crc_once, build_crc_table);
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+        crc = crc_table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put_u32(std::vector<unsigned char>& v, uint32_t x) {
+    v.push_back((x >> 24) & 0xff);
+    v.push_back((x >> 16) & 0xff);
+    v.push_back((x >> 8) & 0xff);
+    v.push_back(x & 0xff);
+}
+
+static void put_chunk(std::vector<unsigned char>& png, const char* type, const std::vector<unsigned char>& data) {
+    put_u32(png, (uint32_t)data.size());
+    size_t start = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data.begin(), data.end());
+    put_u32(png, crc32(0, &png[start], png.size() - start));
+}
+
+bool WritePNG(std::string filename, const unsigned char* rgba, int width, int height, bool flip) {
+    const size_t stride = (size_t)width * 4;
+    const size_t row_bytes = stride + 1;                // each scanline is prefixed with a filter byte (0 = none)
+
+    // build the zlib stream: header, stored deflate blocks (max 65535 bytes each), adler32
+    std::vector<unsigned char> z;
+    z.reserve(row_bytes * height + row_bytes * height / 65535 * 5 + 16);
+    z.push_back(0x78);
+    z.push_back(0x01);
+
+    std::vector<unsigned char> raw(row_bytes * height);
+    for (int y = 0; y < height; y++) {
+        const unsigned char* src = rgba + stride * (flip ? (height - 1 - y) : y);
+        raw[row_bytes * y] = 0;
+        memcpy(&raw[row_bytes * y + 1], src, stride);
+    }
+
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw.size(); ) {             // adler32 with deferred modulo
+        size_t n = std::min<size_t>(5552, raw.size() - i);
+        for (size_t k = 0; k < n; k++) { a += raw[i + k]; b += a; }
+        a %= 65521; b %= 65521;
+        i += n;
+    }
+
+    for (size_t pos = 0; pos < raw.size() || pos == 0; ) {
+        size_t len = std::min<size_t>(65535, raw.size() - pos);
+        bool last = (pos + len == raw.size());
+        z.push_back(last ? 1 : 0);
+        z.push_back(len & 0xff);
+        z.push_back((len >> 8) & 0xff);
+        z.push_back(~len & 0xff);
+        z.push_back((~len >> 8) & 0xff);
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+        if (last) break;
+    }
+    put_u32(z, (b << 16) | a);
+
+    std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    std::vector<unsigned char> ihdr;
+    put_u32(ihdr, width);
+    put_u32(ihdr, height);
+    ihdr.push_back(8);                                  // bit depth
+    ihdr.push_back(6);                                  // color type: RGBA
+    ihdr.push_back(0);                                  // compression
+    ihdr.push_back(0);                                  // filter
+    ihdr.push_back(0);                                  // interlace
+    put_chunk(png, "IHDR", ihdr);
+    put_chunk(png, "IDAT", z);
+    put_chunk(png, "IEND", {});
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        std::cout << "ERROR: unable to open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    out.write((const char*)png.data(), png.size());
+    return (bool)out;
+}
+
+bool WriteRaw(std::string filename, const unsigned char* rgba, int width, int height, bool flip) {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        std::cout << "ERROR: unable to open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    const size_t stride = (size_t)width * 4;
+    for (int y = 0; y < height; y++)
+        out.write((const char*)(rgba + stride * (flip ? (height - 1 - y) : y)), stride);
+    return (bool)out;
+}
+
+void RGBAtoYUV420(const unsigned char* rgba, int width, int height, std::vector<unsigned char>& yuv, bool flip) {
+    const size_t luma = (size_t)width * height;
+    yuv.resize(luma + luma / 2);
+    unsigned char* Y = yuv.data();
+    unsigned char* U = Y + luma;
+    unsigned char* V = U + luma / 4;
+
+    for (int y = 0; y < height; y++) {
+        const unsigned char* row = rgba + (size_t)width * 4 * (flip ? (height - 1 - y) : y);
+        for (int x = 0; x < width; x++) {
+            int r = row[4 * x + 0], g = row[4 * x + 1], b = row[4 * x + 2];
+            Y[(size_t)y * width + x] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+
+    for (int y = 0; y < height; y += 2) {
+        const unsigned char* r0 = rgba + (size_t)width * 4 * (flip ? (height - 1 - y) : y);
+        const unsigned char* r1 = rgba + (size_t)width * 4 * (flip ? (height - 2 - y) : y + 1);
+        for (int x = 0; x < width; x += 2) {
+            int r = r0[4 * x] + r0[4 * x + 4] + r1[4 * x] + r1[4 * x + 4];
+            int g = r0[4 * x + 1] + r0[4 * x + 5] + r1[4 * x + 1] + r1[4 * x + 5];
+            int b = r0[4 * x + 2] + r0[4 * x + 6] + r1[4 * x + 2] + r1[4 * x + 6];
+            size_t i = (size_t)(y / 2) * (width / 2) + x / 2;
+            U[i] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 512) >> 10) + 128);
+            V[i] = (unsigned char)(((112 * r - 94 * g - 18 * b + 512) >> 10) + 128);
+        }
+    }
+}
+
+bool Y4MWriter::Open(std::string filename, int width, int height, int fps) {
+    out.open(filename, std::ios::binary);
+    if (!out) {
+        std::cout << "ERROR: unable to open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    out << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C420jpeg\n";
+    next = 0;
+    pending.clear();
+    return true;
+}
+
+void Y4MWriter::Write(int index, std::vector<unsigned char>&& yuv) {
+    std::lock_guard<std::mutex> lock(m);
+    pending[index] = std::move(yuv);
+    while (!pending.empty() && pending.begin()->first == next) {
+        out << "FRAME\n";
+        out.write((const char*)pending.begin()->second.data(), pending.begin()->second.size());
+        pending.erase(pending.begin());
+        next++;
+    }
+}
+
+void Y4MWriter::Close() {
+    std::lock_guard<std::mutex> lock(m);
+    if (!pending.empty())
+        std::cout << "ERROR: " << pending.size() << " Y4M frames were never written (missing frame " << next << ")" << std::endl;
+    out.close();
+}
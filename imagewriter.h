@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Encode an RGBA8 image as a PNG file. Rows are expected bottom-up (as returned by glReadPixels) unless
+/// flip is false. The image data is stored using uncompressed deflate blocks, which keeps encoding cost
+/// proportional to a memcpy.
+/// </summary>
+bool WritePNG(std::string filename, const unsigned char* rgba, int width, int height, bool flip = true);
+
+/// <summary>
+/// Write the raw RGBA8 pixels (top-down rows) with no header
+/// </summary>
+bool WriteRaw(std::string filename, const unsigned char* rgba, int width, int height, bool flip = true);
+
+/// <summary>
+/// Convert an RGBA8 image into a planar YUV 4:2:0 (BT.601, studio range) frame. Width and height must be even.
+/// </summary>
+void RGBAtoYUV420(const unsigned char* rgba, int width, int height, std::vector<unsigned char>& yuv, bool flip = true);
+
+/// <summary>
+/// Sequential YUV4MPEG2 (*.y4m) stream. Frames may be encoded out of order on worker threads and handed to
+/// Write() with their index; they are buffered and written to disk in index order.
+/// </summary>
+class Y4MWriter {
+    std::ofstream out;
+    std::mutex m;
+    std::map<int, std::vector<unsigned char>> pending;  // encoded frames waiting for their predecessors
+    int next = 0;                                       // index of the next frame to be written
+
+public:
+    bool Open(std::string filename, int width, int height, int fps);
+    void Write(int index, std::vector<unsigned char>&& yuv);
+    void Close();
+};
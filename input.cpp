@@ -0,0 +1,116 @@
+#include "input.h"
+
+void InputQueue::Push(const InputEvent& e) {
+    if (e.type == INPUT_MOVE) {
+        cursor_x = e.x;
+        cursor_y = e.y;
+        if (!events.empty() && events.back().type == INPUT_MOVE) {      // coalesce with the previous move
+            events.back() = e;
+            return;
+        }
+    }
+    events.push_back(e);
+}
+
+void InputQueue::Move(double x, double y) {
+    if (x == cursor_x && y == cursor_y && (events.empty() || events.back().type != INPUT_MOVE))
+        return;                                                         // the cursor did not move
+    InputEvent e;
+    e.type = INPUT_MOVE;
+    e.x = x;
+    e.y = y;
+    Push(e);
+}
+
+void InputQueue::Button(int button, int action, int mods) {
+    InputEvent e;
+    e.type = INPUT_BUTTON;
+    e.x = cursor_x;
+    e.y = cursor_y;
+    e.button = button;
+    e.action = action;
+    e.mods = mods;
+    Push(e);
+}
+
+std::vector<InputEvent> InputQueue::Drain() {
+    std::vector<InputEvent> drained;
+    drained.swap(events);
+    return drained;
+}
+
+void ApplyButton(InputState& state, const InputEvent& e) {
+    if (e.button == INPUT_BUTTON_RIGHT && e.action == INPUT_PRESS) {
+        state.right_pressed = true;
+        state.x = e.x;                                                  // save the mouse position when the right button is pressed
+        state.y = e.y;
+    }
+    if (e.button == INPUT_BUTTON_RIGHT && e.action == INPUT_RELEASE)
+        state.right_pressed = false;
+
+    if (e.button == INPUT_BUTTON_LEFT && e.action == INPUT_PRESS) {
+        if (state.oblique_enable && (e.mods & INPUT_MOD_SHIFT)) {     // shift + left drag rotates the oblique plane
+            state.oblique_drag = true;
+            state.x = e.x;
+            state.y = e.y;
+        }
+        else if (state.crop_enable && (e.mods & INPUT_MOD_CONTROL) && !state.gui_focused) {   // ctrl + left drag moves a face of the crop box
+            state.crop_drag = true;
+            state.x = e.x;
+            state.y = e.y;
+        }
+        else if (state.roi_tool != 0 && !state.gui_focused) {          // with a measurement tool selected, left drag draws it
+            state.roi_drag = true;
+            state.roi_screen[0] = state.roi_screen[2] = (float)e.x;
+            state.roi_screen[1] = state.roi_screen[3] = (float)e.y;
+        }
+        else
+            state.left_pressed = true;
+    }
+    if (e.button == INPUT_BUTTON_LEFT && e.action == INPUT_RELEASE) {
+        state.left_pressed = false;
+        state.oblique_drag = false;
+        state.roi_drag = false;
+        state.crop_drag = false;
+    }
+}
+
+bool ApplyMove(InputState& state, const InputEvent& e, const InputHandlers& handlers) {
+    if (state.right_pressed) {
+        double dx = e.x - state.x;
+        double dy = e.y - state.y;
+        state.x = e.x;
+        state.y = e.y;
+        if (handlers.orbit) handlers.orbit(dx, dy);
+        return true;
+    }
+    else if (state.roi_drag) {
+        state.roi_screen[2] = (float)e.x;
+        state.roi_screen[3] = (float)e.y;
+    }
+    else if (state.oblique_drag) {
+        double dx = e.x - state.x;
+        double dy = e.y - state.y;
+        state.x = e.x;
+        state.y = e.y;
+        if (handlers.rotate) handlers.rotate(dx, dy);
+        return true;
+    }
+    return false;                                                       // crop drags are applied by the caller (they need the projection)
+}
+
+bool ProcessInput(InputState& state, const std::vector<InputEvent>& events, const InputHandlers& handlers,
+    double& select_x, double& select_y, bool& view_moved) {
+    bool select = false;
+    view_moved = false;
+    for (const InputEvent& e : events) {
+        if (e.type == INPUT_BUTTON) ApplyButton(state, e);
+        else view_moved |= ApplyMove(state, e, handlers);
+        if (state.left_pressed && (e.type == INPUT_MOVE || e.action == INPUT_PRESS)) {
+            select = true;
+            select_x = e.x;
+            select_y = e.y;
+        }
+    }
+    return select;
+}
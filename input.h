@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/// Types of input events recorded by InputQueue
+enum InputEventType { INPUT_MOVE = 0, INPUT_BUTTON };
+
+/// Buttons, actions and modifiers used by the drag state machine (the values of GLFW)
+enum InputButton { INPUT_BUTTON_LEFT = 0, INPUT_BUTTON_RIGHT = 1 };
+enum InputAction { INPUT_RELEASE = 0, INPUT_PRESS = 1 };
+enum InputModifier { INPUT_MOD_SHIFT = 0x0001, INPUT_MOD_CONTROL = 0x0002 };
+
+/// <summary>
+/// Mouse event recorded by the window callbacks. Buttons, actions and modifiers keep the values of the windowing
+/// library (GLFW) so that the queue itself does not depend on it.
+/// </summary>
+struct InputEvent {
+    int type = INPUT_MOVE;
+    double x = 0.0, y = 0.0;                            // cursor position (window coordinates) when the event occurred
+    int button = 0;
+    int action = 0;
+    int mods = 0;
+};
+
+/// <summary>
+/// Queue of mouse events between two frames. The callbacks only record events; the main loop drains the queue once
+/// per frame and applies them in order. Consecutive moves are coalesced as they arrive (the last position wins), so
+/// a frame sees at most one move between two button events and none at all if the cursor did not move.
+/// </summary>
+class InputQueue {
+    std::vector<InputEvent> events;
+    double cursor_x = 0.0, cursor_y = 0.0;              // last position reported by a move
+
+public:
+    void Move(double x, double y);
+    void Button(int button, int action, int mods);      // recorded at the last reported cursor position
+    void Push(const InputEvent& e);                     // record a prepared event (ex. replayed from a log)
+
+    /// <summary>
+    /// Returns the events recorded since the last call and empties the queue
+    /// </summary>
+    std::vector<InputEvent> Drain();
+
+    bool Empty() const { return events.empty(); }
+    size_t Size() const { return events.size(); }
+    double X() const { return cursor_x; }
+    double Y() const { return cursor_y; }
+};
+
+/// <summary>
+/// Mouse drag state of the viewer. The modes are copied from the GUI before the events of a frame are applied and
+/// decide what a left drag does; the rest is updated by ProcessInput().
+/// </summary>
+struct InputState {
+    // modes (set by the caller)
+    bool oblique_enable = false;                        // shift + left drag rotates the oblique plane
+    bool crop_enable = false;                           // ctrl + left drag moves a face of the crop box
+    int roi_tool = 0;                                   // left drag draws a measurement (0 = no tool selected)
+    bool gui_focused = false;                           // the cursor is over the GUI (crop and measurement drags are ignored)
+
+    // drags in progress
+    bool left_pressed = false;                          // left drag that selects positions on the slices
+    bool right_pressed = false;                         // right drag that orbits the camera
+    bool oblique_drag = false;
+    bool crop_drag = false;
+    bool roi_drag = false;
+    double x = 0.0, y = 0.0;                            // cursor position at the start of the drag or its last step
+    float roi_screen[4] = { 0.0f, 0.0f, 0.0f, 0.0f };   // start and end of the measurement drag (x0, y0, x1, y1)
+};
+
+/// <summary>
+/// Actions of the drags that change the 3D view, called with the cursor displacement (in window coordinates) of
+/// each move. Either may be empty.
+/// </summary>
+struct InputHandlers {
+    std::function<void(double dx, double dy)> orbit;    // right drag
+    std::function<void(double dx, double dy)> rotate;   // shift + left drag rotates the oblique plane
+};
+
+/// <summary>
+/// Start or end a drag
+/// </summary>
+void ApplyButton(InputState& state, const InputEvent& e);
+
+/// <summary>
+/// Apply a cursor move to the active drag
+/// </summary>
+/// <returns>true if the 3D view changed (orbit or oblique plane rotation)</returns>
+bool ApplyMove(InputState& state, const InputEvent& e, const InputHandlers& handlers);
+
+/// <summary>
+/// Apply the mouse events recorded since the last frame in order. Moves have already been coalesced by the queue,
+/// so a frame in which the mouse did not move or click does no work at all.
+/// </summary>
+/// <param name="select_x">Receives the cursor position of the last left click/drag that selects a position</param>
+/// <param name="view_moved">Set to true if the camera or the oblique plane moved</param>
+/// <returns>true if a left click or drag selected a new position on the slices</returns>
+bool ProcessInput(InputState& state, const std::vector<InputEvent>& events, const InputHandlers& handlers,
+    double& select_x, double& select_y, bool& view_moved);
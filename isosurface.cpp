@@ -0,0 +1,300 @@
+#include "isosurface.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+static std::string IsoVertexSource =
+"# version 330 core\n"
+"layout(location = 0) in vec4 edge;\n"                            // first voxel of the edge (xyz) and its axis (w)
+"layout(location = 1) in vec2 values;\n"                          // voxel values at both ends of the edge
+"uniform mat4 MVP;\n"
+"uniform vec3 volume_size;\n"
+"uniform vec3 dims;\n"
+"uniform float iso;\n"
+"uniform int channel;\n"
+"uniform sampler3D volumeTexture;\n"
+"out vec3 normal;\n"
+"float sample_volume(vec3 tex)\n"
+"{\n"
+"    return texture(volumeTexture, tex)[channel];\n"
+"}\n"
+"void main()\n"
+"{\n"
+"    float t = clamp((iso - values.x) / (values.y - values.x), 0.0, 1.0);\n"
+"    vec3 p = edge.xyz;\n"
+"    p[int(edge.w + 0.5)] += t;\n"
+"    vec3 tex = (p + 0.5) / dims;\n"
+"    vec3 g;\n"                                                   // gradient (central differences) gives the normal
+"    for (int i = 0; i < 3; i++) {\n"
+"        vec3 d = vec3(0.0);\n"
+"        d[i] = 1.0 / dims[i];\n"
+"        g[i] = (sample_volume(tex + d) - sample_volume(tex - d)) * dims[i] / volume_size[i];\n"
+"    }\n"
+"    normal = -g;\n"
+"    gl_Position = MVP * vec4((tex - 0.5) * volume_size, 1.0);\n"
+"};\n";
+
+static std::string IsoFragmentSource =
+"# version 330 core\n"
+"in vec3 normal;\n"
+"uniform vec3 color;\n"
+"uniform vec3 light;\n"
+"out vec4 fragment;\n"
+"void main()\n"
+"{\n"
+"    float n = length(normal);\n"
+"    float d = (n > 0.0) ? abs(dot(normal / n, light)) : 1.0;\n"     // two-sided headlight
+"    fragment = vec4(color * (0.25 + 0.75 * d), 1.0);\n"
+"};\n";
+
+// cube corners and edges (corner i has x, y, z from bits 0, 1, 2 of i)
+static const int EdgeCorners[12][2] = {
+    { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },             // x edges
+    { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },             // y edges
+    { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }              // z edges
+};
+
+// faces as corner loops, counter-clockwise when seen from outside the cube
+static const int FaceCorners[6][4] = {
+    { 0, 4, 6, 2 }, { 1, 3, 7, 5 },                     // -x, +x
+    { 0, 1, 5, 4 }, { 2, 6, 7, 3 },                     // -y, +y
+    { 0, 2, 3, 1 }, { 4, 5, 7, 6 }                      // -z, +z
+};
+
+static int8_t TriangleTable[256][16];                   // edges of the triangles of each case (-1 terminated)
+
+/// <summary>
+/// Build the marching cubes triangle table. On each face the crossing points are joined so that the inside
+/// corners are separated (a fixed rule that adjacent cubes agree on, so the surface has no cracks), the segments
+/// are chained into closed loops around the cube and each loop is triangulated as a fan.
+/// </summary>
+static void BuildTriangleTable() {
+    int edge_of[8][8];
+    for (int e = 0; e < 12; e++) {
+        edge_of[EdgeCorners[e][0]][EdgeCorners[e][1]] = e;
+        edge_of[EdgeCorners[e][1]][EdgeCorners[e][0]] = e;
+    }
+
+    for (int c = 0; c < 256; c++) {
+        int next[12];
+        for (int e = 0; e < 12; e++) next[e] = -1;
+        for (int f = 0; f < 6; f++) {
+            int crossing[4], entry[4], n = 0;
+            for (int k = 0; k < 4; k++) {
+                int a = FaceCorners[f][k], b = FaceCorners[f][(k + 1) % 4];
+                bool ia = (c >> a) & 1, ib = (c >> b) & 1;
+                if (ia == ib) continue;
+                crossing[n] = edge_of[a][b];
+                entry[n++] = ib;                        // the loop enters the inside region at this crossing
+            }
+            for (int k = 0; k < n; k++)                 // join each entry to the following exit
+                if (entry[k]) next[crossing[k]] = crossing[(k + 1) % n];
+        }
+
+        int t = 0;
+        bool used[12] = {};
+        for (int e = 0; e < 12; e++) {
+            if (next[e] < 0 || used[e]) continue;
+            int loop[12], n = 0;
+            for (int i = e; !used[i]; i = next[i]) {
+                used[i] = true;
+                loop[n++] = i;
+            }
+            for (int i = 1; i + 1 < n && t + 3 < 16; i++) {
+                TriangleTable[c][t++] = (int8_t)loop[0];
+                TriangleTable[c][t++] = (int8_t)loop[i + 1];
+                TriangleTable[c][t++] = (int8_t)loop[i];
+            }
+        }
+        for (; t < 16; t++) TriangleTable[c][t] = -1;
+    }
+}
+
+void glIsosurface::Reset() {
+    bricks.clear();
+    std::vector<IsoVertex>().swap(vertices);           // release the memory, the mesh may not be rebuilt for a while
+    std::vector<uint32_t>().swap(indices);
+    source = nullptr;
+    level = -1;
+    dirty = true;
+}
+
+/// <summary>
+/// Run marching cubes over the cells of one brick. Vertices are looked up by edge in table, whose entries are
+/// only valid when the matching stamp equals id (so the table never has to be cleared between bricks).
+/// </summary>
+void glIsosurface::ExtractBrick(const VoxelGrid& g, const MinMaxGrid& ranges, size_t b, std::vector<uint32_t>& table, std::vector<uint32_t>& stamp, uint32_t id) {
+    Brick& brick = bricks[b];
+    brick.vertices.clear();
+    brick.indices.clear();
+    if (!(ranges.Min(b, source_channel) <= level && level < ranges.Max(b, source_channel))) return;
+
+    const int B = (int)ranges.BrickSize();
+    const int S = B + 1;                                // vertices per brick edge
+    glm::ivec3 origin = ranges.Origin(b);
+    int bx = origin.x, by = origin.y, bz = origin.z;
+    int cx = std::min(B, (int)g.X - 1 - bx), cy = std::min(B, (int)g.Y - 1 - by), cz = std::min(B, (int)g.Z - 1 - bz);
+    const size_t dx = g.C, dy = g.X * g.C, dz = g.X * g.Y * g.C;
+    const size_t corner_offset[8] = { 0, dx, dy, dx + dy, dz, dx + dz, dy + dz, dx + dy + dz };
+
+    for (int z = 0; z < cz; z++) {
+        for (int y = 0; y < cy; y++) {
+            const unsigned char* p = g.voxel(bx, by + y, bz + z) + source_channel;
+            for (int x = 0; x < cx; x++, p += g.C) {
+                int c = 0;
+                for (int k = 0; k < 8; k++)
+                    c |= (p[corner_offset[k]] > level) << k;
+                if (c == 0 || c == 255) continue;
+
+                const int8_t* tri = TriangleTable[c];
+                for (int t = 0; t < 16 && tri[t] >= 0; t++) {
+                    int e = tri[t];
+                    int a = EdgeCorners[e][0];          // the lower corner is the origin of the edge
+                    int axis = e / 4;
+                    int ox = x + (a & 1), oy = y + ((a >> 1) & 1), oz = z + ((a >> 2) & 1);
+                    size_t key = ((size_t)(oz * S + oy) * S + ox) * 3 + axis;
+                    if (stamp[key] != id) {
+                        stamp[key] = id;
+                        table[key] = (uint32_t)brick.vertices.size();
+                        IsoVertex v;
+                        v.x = (float)(bx + ox);
+                        v.y = (float)(by + oy);
+                        v.z = (float)(bz + oz);
+                        v.axis = (float)axis;
+                        v.v0 = p[corner_offset[a]];
+                        v.v1 = p[corner_offset[EdgeCorners[e][1]]];
+                        brick.vertices.push_back(v);
+                    }
+                    brick.indices.push_back(table[key]);
+                }
+            }
+        }
+    }
+}
+
+bool glIsosurface::Update(const VoxelGrid& g, const MinMaxGrid& ranges) {
+    static std::once_flag tables;
+    std::call_once(tables, BuildTriangleTable);
+    if (!g.data || g.X < 2 || g.Y < 2 || g.Z < 2 || !ranges.Matches(g)) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t c = std::min((size_t)std::max(channel, 0), g.C - 1);
+    if (g.data != source || c != source_channel || bricks.size() != ranges.Count()) {
+        source = g.data;
+        source_channel = c;
+        bricks.assign(ranges.Count(), Brick());
+        level = -1;
+    }
+
+    // voxels are 8-bit, so the set of voxels above iso (the topology) only depends on its integer part
+    int new_level = std::clamp((int)std::floor(iso), -1, 255);
+    if (new_level == level) return false;
+
+    // only bricks holding a value in (old, new] can change; with no previous mesh every brick is visited
+    int lo = std::min(level, new_level), hi = std::max(level, new_level);
+    bool all = (level < 0);
+    std::vector<size_t> changed;
+    for (size_t b = 0; b < bricks.size(); b++) {
+        if (all || ranges.MayContain(b, c, lo + 1, hi)) changed.push_back(b);
+    }
+    level = new_level;
+
+    // bricks are handed out dynamically since their cost varies widely
+    std::atomic<size_t> next(0);
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    parallel_for(threads, [&](size_t, size_t) {
+        const size_t S = ranges.BrickSize() + 1;
+        std::vector<uint32_t> table(S * S * S * 3), stamp(S * S * S * 3, 0);
+        uint32_t id = 0;
+        for (size_t i = next++; i < changed.size(); i = next++)
+            ExtractBrick(g, ranges, changed[i], table, stamp, ++id);
+    });
+
+    // concatenate the brick meshes
+    size_t nv = 0, ni = 0;
+    for (const Brick& b : bricks) {
+        nv += b.vertices.size();
+        ni += b.indices.size();
+    }
+    vertices.resize(nv);
+    indices.resize(ni);
+    nv = ni = 0;
+    for (const Brick& b : bricks) {
+        std::copy(b.vertices.begin(), b.vertices.end(), vertices.begin() + nv);
+        for (uint32_t i : b.indices) indices[ni++] = (uint32_t)nv + i;
+        nv += b.vertices.size();
+    }
+    dirty = true;
+
+    last_bricks = changed.size();
+    last_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void glIsosurface::Draw(glm::mat4 MVP, glm::vec3 volume_size, glm::vec3 dims, glm::vec3 light) {
+    if (!vao) {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(IsoVertex), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(IsoVertex), (void*)(4 * sizeof(float)));
+        glBindVertexArray(0);
+        shader = new glProgram(IsoVertexSource, IsoFragmentSource);
+    }
+    if (dirty) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(IsoVertex), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(vao);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+        uploaded_indices = indices.size();
+        uploaded_bytes = vertices.size() * sizeof(IsoVertex) + indices.size() * sizeof(uint32_t);
+        dirty = false;
+    }
+    if (uploaded_indices == 0) return;
+
+    shader->Bind();
+    shader->SetUniformMat4f("MVP", MVP);
+    shader->SetUniform3f("volume_size", volume_size.x, volume_size.y, volume_size.z);
+    shader->SetUniform3f("dims", dims.x, dims.y, dims.z);
+    shader->SetUniform1f("iso", iso);
+    shader->SetUniform1i("channel", (int)source_channel);
+    shader->SetUniform1i("volumeTexture", 0);
+    shader->SetUniform3f("color", color.x, color.y, color.z);
+    shader->SetUniform3f("light", light.x, light.y, light.z);
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, (GLsizei)uploaded_indices, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+    shader->Unbind();
+}
+
+void glIsosurface::Destroy() {
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (vbo) glDeleteBuffers(1, &vbo);
+    if (ebo) glDeleteBuffers(1, &ebo);
+    delete shader;
+    vao = vbo = ebo = 0;
+    shader = nullptr;
+    uploaded_indices = 0;
+    uploaded_bytes = 0;
+    dirty = true;
+}
+
+size_t glIsosurface::HostBytes() const {
+    size_t bytes = vertices.capacity() * sizeof(IsoVertex) + indices.capacity() * sizeof(uint32_t);
+    for (const Brick& b : bricks)
+        bytes += b.vertices.capacity() * sizeof(IsoVertex) + b.indices.capacity() * sizeof(uint32_t);
+    return bytes;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "tira/graphics_gl.h"
+#include "program.h"
+#include "minmax.h"
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Isosurface vertex. Vertices lie on the edge between voxel (x, y, z) and its neighbor along the given axis; the
+/// position along the edge is computed in the vertex shader from the two voxel values and the current iso-value,
+/// so the mesh only has to be rebuilt when the iso-value crosses an integer (the topology changes).
+/// </summary>
+struct IsoVertex {
+    float x, y, z;                                      // first voxel of the edge
+    float axis;                                         // 0, 1 or 2
+    float v0, v1;                                       // voxel values at both ends of the edge
+};
+
+/// <summary>
+/// Isosurface of the primary volume rendered in the 3D view. The surface is extracted with marching cubes over the
+/// bricks of the volume's MinMaxGrid in parallel: bricks whose range does not contain the iso-value are skipped,
+/// vertices are shared within a brick through a table indexed by edge, and the mesh of each brick is cached so that
+/// a change of iso-value only re-extracts the bricks that contain a voxel between the old and new iso-values.
+/// </summary>
+class glIsosurface {
+    struct Brick {
+        std::vector<IsoVertex> vertices;
+        std::vector<uint32_t> indices;                  // triangle list (indices into vertices)
+    };
+    std::vector<Brick> bricks;
+    const unsigned char* source = nullptr;              // volume the cache was built from
+    size_t source_channel = 0;
+    int level = -1;                                     // floor of the iso-value the cache was built for
+
+    std::vector<IsoVertex> vertices;                    // concatenated meshes of all bricks
+    std::vector<uint32_t> indices;
+    bool dirty = false;                                 // the concatenated mesh has not been uploaded
+
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    size_t uploaded_indices = 0;
+    size_t uploaded_bytes = 0;                          // size of the vertex and index buffers
+    glProgram* shader = nullptr;
+
+    void ExtractBrick(const VoxelGrid& grid, const MinMaxGrid& ranges, size_t b, std::vector<uint32_t>& table, std::vector<uint32_t>& stamp, uint32_t id);
+
+public:
+    bool visible = false;
+    float iso = 128.0f;                                 // iso-value (in voxel units, 0 - 255)
+    int channel = 0;
+    glm::vec3 color = glm::vec3(0.9f, 0.75f, 0.6f);
+
+    size_t last_bricks = 0;                             // bricks extracted by the last Update()
+    double last_ms = 0.0;                               // duration of the last Update()
+
+    /// <summary>
+    /// Bring the mesh up to date with iso and channel. Cheap when only the fractional part of iso changed.
+    /// </summary>
+    /// <param name="ranges">Brick ranges of grid</param>
+    /// <returns>true if the mesh was modified</returns>
+    bool Update(const VoxelGrid& grid, const MinMaxGrid& ranges);
+
+    /// <summary>
+    /// Forget the cached meshes (call when the volume data changes)
+    /// </summary>
+    void Reset();
+
+    /// <summary>
+    /// Draw the surface (the volume texture must be bound to unit 0)
+    /// </summary>
+    /// <param name="dims">Size of the volume in voxels</param>
+    /// <param name="light">Direction towards the light (world space)</param>
+    void Draw(glm::mat4 MVP, glm::vec3 volume_size, glm::vec3 dims, glm::vec3 light);
+    void Destroy();                                     // release the GL objects (requires a current context)
+
+    size_t Triangles() const { return indices.size() / 3; }
+    size_t GpuBytes() const { return uploaded_bytes; }
+    size_t HostBytes() const;                           // cached brick meshes and the concatenated mesh
+    const std::vector<IsoVertex>& Vertices() const { return vertices; }
+    const std::vector<uint32_t>& Indices() const { return indices; }
+};
@@ -0,0 +1,76 @@
+#include "labels.h"
+#include "npy.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+bool LabelVolume::Load(std::string filename, size_t budget) {
+    NpyHeader header;
+    if (!ReadNpyHeader(filename, header)) {
+        std::cout << "ERROR: unable to read the NumPy header of " << filename << std::endl;
+        return false;
+    }
+    if ((header.kind != 'u' && header.kind != 'i') || (header.itemsize != 1 && header.itemsize != 2 && header.itemsize != 4)) {
+        std::cout << "ERROR: label volumes must be 8, 16 or 32-bit integers (" << filename << " is " << header.descr << ")" << std::endl;
+        return false;
+    }
+    if (header.fortran_order || header.shape.size() < 3 || (header.shape.size() == 4 && header.shape[3] != 1) || header.shape.size() > 4) {
+        std::cout << "ERROR: label volumes must be C-ordered arrays of shape (Z, Y, X)" << std::endl;
+        return false;
+    }
+    if (header.bytes() > budget) {
+        std::cout << "ERROR: label volume (" << header.bytes() / (1024 * 1024) << " MB) exceeds the memory budget" << std::endl;
+        return false;
+    }
+
+    std::vector<char> data(header.bytes());
+    std::ifstream in(filename, std::ios::binary);
+    in.seekg(header.offset);
+    in.read(data.data(), data.size());
+    if (!in) {
+        std::cout << "ERROR: " << filename << " is truncated" << std::endl;
+        return false;
+    }
+
+    return Set(data.data(), header.shape[2], header.shape[1], header.shape[0], header.itemsize);
+}
+
+bool LabelVolume::Set(const void* data, size_t x, size_t y, size_t z, size_t bytes_per_label) {
+    Clear();
+    X = x;
+    Y = y;
+    Z = z;
+    itemsize = bytes_per_label;
+
+    // signed labels are uploaded as their unsigned bit pattern (ids are only compared and hashed)
+    GLint internal_format = (itemsize == 1) ? GL_R8UI : (itemsize == 2) ? GL_R16UI : GL_R32UI;
+    GLenum type = (itemsize == 1) ? GL_UNSIGNED_BYTE : (itemsize == 2) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_3D, 0, internal_format, (GLsizei)X, (GLsizei)Y, (GLsizei)Z, 0, GL_RED_INTEGER, type, data);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);   // integer textures cannot be filtered
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    return true;
+}
+
+void LabelVolume::Clear() {
+    if (texture) glDeleteTextures(1, &texture);
+    texture = 0;
+    X = Y = Z = itemsize = 0;
+}
+
+void LabelVolume::Bind(glProgram* shader) {
+    glActiveTexture(GL_TEXTURE0 + LABEL_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glActiveTexture(GL_TEXTURE0);
+    shader->SetUniform1i("labelTexture", LABEL_TEXTURE_UNIT);
+    shader->SetUniform1i("label_enable", (Loaded() && visible) ? 1 : 0);
+    shader->SetUniform1i("label_outline", outline ? 1 : 0);
+    shader->SetUniform1f("label_opacity", opacity);
+}
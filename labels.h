@@ -0,0 +1,46 @@
+#pragma once
+
+#include "tira/graphics_gl.h"
+#include "program.h"
+
+#include <string>
+
+#define LABEL_TEXTURE_UNIT 5                            // texture unit used by the label sampler (after the overlays)
+
+/// <summary>
+/// Integer label volume (ex. a segmentation) rendered over the slices. Labels are stored in an unsigned integer
+/// texture and read with texelFetch, so ids are never interpolated; colors are generated in the shader by hashing
+/// the id, which avoids storing a precomputed RGB volume.
+/// </summary>
+class LabelVolume {
+    GLuint texture = 0;
+
+public:
+    size_t X = 0, Y = 0, Z = 0;
+    size_t itemsize = 0;                                // bytes per label (1, 2 or 4)
+    bool visible = true;
+    bool outline = false;                               // only draw the boundaries between labels
+    float opacity = 0.5f;
+
+    /// <summary>
+    /// Load an integer NumPy array (uint8/16/32 or int8/16/32) with shape (Z, Y, X) or (Z, Y, X, 1)
+    /// </summary>
+    /// <param name="budget">Maximum number of bytes the label texture may occupy</param>
+    bool Load(std::string filename, size_t budget);
+
+    /// <summary>
+    /// Upload labels that were computed in memory (x-fastest, itemsize bytes per label)
+    /// </summary>
+    bool Set(const void* data, size_t x, size_t y, size_t z, size_t bytes_per_label);
+    void Clear();
+
+    bool Loaded() const { return texture != 0; }
+    GLuint Texture() const { return texture; }
+    size_t bytes() const { return X * Y * Z * itemsize; }
+
+    /// <summary>
+    /// Bind the label texture to LABEL_TEXTURE_UNIT and set the label uniforms of the slicer shader. The sampler
+    /// uniform is always assigned so it never aliases the float sampler on unit 0.
+    /// </summary>
+    void Bind(glProgram* shader);
+};
@@ -42,6 +42,7 @@ SOFTWARE.
 #include <sys/stat.h>
 #include <cstdio>
 #include <cerrno>
+#include <chrono>
 
 // this option need c++17
 #ifdef USE_STD_FILESYSTEM
@@ -354,6 +355,47 @@ namespace IGFD
 	}
 #endif
 
+	// sort a file list, large lists on all cores : chunks are sorted in parallel then merged pairwise (also in parallel)
+	template<typename T>
+	inline void inParallelSort(std::vector<std::shared_ptr<IGFD::FileInfos>>& vList, T vCompare)
+	{
+		const size_t minChunkSize = 8192;
+		size_t countChunks = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), vList.size() / minChunkSize);
+		if (countChunks < 2)
+		{
+			std::sort(vList.begin(), vList.end(), vCompare);
+			return;
+		}
+
+		std::vector<size_t> bounds(countChunks + 1);
+		for (size_t i = 0; i <= countChunks; ++i)
+			bounds[i] = vList.size() * i / countChunks;
+
+		std::vector<std::thread> workers;
+		for (size_t i = 0; i < countChunks; ++i)
+			workers.emplace_back([&vList, &bounds, vCompare, i]()
+				{
+					std::sort(vList.begin() + bounds[i], vList.begin() + bounds[i + 1], vCompare);
+				});
+		for (auto& worker : workers)
+			worker.join();
+
+		for (size_t step = 1; step < countChunks; step *= 2)
+		{
+			workers.clear();
+			for (size_t i = 0; i + step < countChunks; i += 2 * step)
+			{
+				size_t first = bounds[i], middle = bounds[i + step], last = bounds[std::min(i + 2 * step, countChunks)];
+				workers.emplace_back([&vList, vCompare, first, middle, last]()
+					{
+						std::inplace_merge(vList.begin() + first, vList.begin() + middle, vList.begin() + last, vCompare);
+					});
+			}
+			for (auto& worker : workers)
+				worker.join();
+		}
+	}
+
 	/////////////////////////////////////////////////////////////////////////////////////
 	//// FILE EXTENTIONS INFOS //////////////////////////////////////////////////////////
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -1317,6 +1359,12 @@ namespace IGFD
 		puFsRoot = std::string(1u, PATH_SEP);
 	}
 
+	IGFD::FileManager::~FileManager()
+	{
+		prCancelScan();
+		prJoinCancelledScans(true);
+	}
+
 	void IGFD::FileManager::OpenCurrentPath(const FileDialogInternal& vFileDialogInternal)
 	{
 		puShowDrives = false;
@@ -1356,7 +1404,7 @@ namespace IGFD
 #ifdef USE_CUSTOM_SORTING_ICON
 				puHeaderFileName = tableHeaderAscendingIcon + puHeaderFileName;
 #endif // USE_CUSTOM_SORTING_ICON
-				std::sort(vFileInfosList.begin(), vFileInfosList.end(),
+				inParallelSort(vFileInfosList,
 					[](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool
 					{
 						if (!a.use_count() || !b.use_count())
@@ -1385,7 +1433,7 @@ namespace IGFD
 #ifdef USE_CUSTOM_SORTING_ICON
 				puHeaderFileName = tableHeaderDescendingIcon + puHeaderFileName;
 #endif // USE_CUSTOM_SORTING_ICON
-				std::sort(vFileInfosList.begin(), vFileInfosList.end(),
+				inParallelSort(vFileInfosList,
 					[](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool
 					{
 						if (!a.use_count() || !b.use_count())
@@ -1417,7 +1465,7 @@ namespace IGFD
 #ifdef USE_CUSTOM_SORTING_ICON
 				puHeaderFileType = tableHeaderAscendingIcon + puHeaderFileType;
 #endif // USE_CUSTOM_SORTING_ICON
-				std::sort(vFileInfosList.begin(), vFileInfosList.end(),
+				inParallelSort(vFileInfosList,
 					[](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool
 					{
 						if (!a.use_count() || !b.use_count())
@@ -1432,7 +1480,7 @@ namespace IGFD
 #ifdef USE_CUSTOM_SORTING_ICON
 				puHeaderFileType = tableHeaderDescendingIcon + puHeaderFileType;
 #endif // USE_CUSTOM_SORTING_ICON
-				std::sort(vFileInfosList.begin(), vFileInfosList.end(),
+				inParallelSort(vFileInfosList,
 					[](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool
 					{
 						if (!a.use_count() || !b.use_count())
@@ -1450,7 +1498,7 @@ namespace IGFD
 #ifdef USE_CUSTOM_SORTING_ICON
 				puHeaderFileSize = tableHeaderAscendingIcon + puHeaderFileSize;
 #endif // USE_CUSTOM_SORTING_ICON
-				std::sort(vFileInfosList.begin(), vFileInfosList.end(),
+				inParallelSort(vFileInfosList,
 					[](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool
 					{
 						if (!a.use_count() || !b.use_count())
@@ -1465,7 +1513,7 @@ namespace IGFD
 #ifdef USE_CUSTOM_SORTING_ICON
 				puHeaderFileSize = tableHeaderDescendingIcon + puHeaderFileSize;
 #endif // USE_CUSTOM_SORTING_ICON
-				std::sort(vFileInfosList.begin(), vFileInfosList.end(),
+				inParallelSort(vFileInfosList,
 					[](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool
 					{
 						if (!a.use_count() || !b.use_count())
@@ -1483,7 +1531,7 @@ namespace IGFD
 #ifdef USE_CUSTOM_SORTING_ICON
 				puHeaderFileDate = tableHeaderAscendingIcon + puHeaderFileDate;
 #endif // USE_CUSTOM_SORTING_ICON
-				std::sort(vFileInfosList.begin(), vFileInfosList.end(),
+				inParallelSort(vFileInfosList,
 					[](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool
 					{
 						if (!a.use_count() || !b.use_count())
@@ -1498,7 +1546,7 @@ namespace IGFD
 #ifdef USE_CUSTOM_SORTING_ICON
 				puHeaderFileDate = tableHeaderDescendingIcon + puHeaderFileDate;
 #endif // USE_CUSTOM_SORTING_ICON
-				std::sort(vFileInfosList.begin(), vFileInfosList.end(),
+				inParallelSort(vFileInfosList,
 					[](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool
 					{
 						if (!a.use_count() || !b.use_count())
@@ -1521,7 +1569,7 @@ namespace IGFD
 #ifdef USE_CUSTOM_SORTING_ICON
 				puHeaderFileThumbnails = tableHeaderAscendingIcon + puHeaderFileThumbnails;
 #endif // USE_CUSTOM_SORTING_ICON
-				std::sort(vFileInfosList.begin(), vFileInfosList.end(),
+				inParallelSort(vFileInfosList,
 					[](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool
 					{
 						if (!a.use_count() || !b.use_count())
@@ -1539,7 +1587,7 @@ namespace IGFD
 #ifdef USE_CUSTOM_SORTING_ICON
 				puHeaderFileThumbnails = tableHeaderDescendingIcon + puHeaderFileThumbnails;
 #endif // USE_CUSTOM_SORTING_ICON
-				std::sort(vFileInfosList.begin(), vFileInfosList.end(),
+				inParallelSort(vFileInfosList,
 					[](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool
 					{
 						if (!a.use_count() || !b.use_count())
@@ -1561,6 +1609,8 @@ namespace IGFD
 	{
 		prFilteredFileList.clear();
 		prFileList.clear();
+		prFilteredSearchTag.clear();
+		prFilteredSourceSize = 0;
 	}
 
 	void IGFD::FileManager::ClearPathLists()
@@ -1569,7 +1619,7 @@ namespace IGFD
 		prPathList.clear();
 	}
 
-	void IGFD::FileManager::AddFile(const FileDialogInternal& vFileDialogInternal, const std::string& vPath, const std::string& vFileName, const FileType& vFileType)
+	std::shared_ptr<FileInfos> IGFD::FileManager::prMakeFileInfos(const std::string& vPath, const std::string& vFileName, const FileType& vFileType)
 	{
 		auto infos = std::make_shared<FileInfos>();
 
@@ -1578,11 +1628,6 @@ namespace IGFD
 		infos->fileNameExt_optimized = Utils::LowerCaseString(infos->fileNameExt);
 		infos->fileType = vFileType;
 
-		if (infos->fileNameExt.empty() || (infos->fileNameExt == "." && !vFileDialogInternal.puFilterManager.puDLGFilters.empty())) return; // filename empty or filename is the current dir '.' //-V807
-		if (infos->fileNameExt != ".." && (vFileDialogInternal.puDLGflags & ImGuiFileDialogFlags_DontShowHiddenFiles) && infos->fileNameExt[0] == '.') // dont show hidden files
-			if (!vFileDialogInternal.puFilterManager.puDLGFilters.empty() || (vFileDialogInternal.puFilterManager.puDLGFilters.empty() && infos->fileNameExt != ".")) // except "." if in directory mode //-V728
-				return;
-
 		if (infos->fileType.isFile()
 			|| infos->fileType.isLinkToUnknown()) // link can have the same extention of a file
 		{
@@ -1591,18 +1636,37 @@ namespace IGFD
 			{
 				infos->fileExt = infos->fileNameExt.substr(lpt);
 			}
+		}
 
-			if (!vFileDialogInternal.puFilterManager.IsCoveredByFilters(infos->fileNameExt, infos->fileExt,
+		prCompleteFileInfos(infos);
+		return infos;
+	}
+
+	void IGFD::FileManager::prAddFileInfos(const FileDialogInternal& vFileDialogInternal, const std::shared_ptr<FileInfos>& vInfos)
+	{
+		if (vInfos->fileNameExt.empty() || (vInfos->fileNameExt == "." && !vFileDialogInternal.puFilterManager.puDLGFilters.empty())) return; // filename empty or filename is the current dir '.' //-V807
+		if (vInfos->fileNameExt != ".." && (vFileDialogInternal.puDLGflags & ImGuiFileDialogFlags_DontShowHiddenFiles) && vInfos->fileNameExt[0] == '.') // dont show hidden files
+			if (!vFileDialogInternal.puFilterManager.puDLGFilters.empty() || (vFileDialogInternal.puFilterManager.puDLGFilters.empty() && vInfos->fileNameExt != ".")) // except "." if in directory mode //-V728
+				return;
+
+		if (vInfos->fileType.isFile()
+			|| vInfos->fileType.isLinkToUnknown()) // link can have the same extention of a file
+		{
+			if (!vFileDialogInternal.puFilterManager.IsCoveredByFilters(vInfos->fileNameExt, vInfos->fileExt,
 				(vFileDialogInternal.puDLGflags & ImGuiFileDialogFlags_CaseInsensitiveExtention) != 0))
 			{
 				return;
 			}
 		}
 
-		vFileDialogInternal.puFilterManager.prFillFileStyle(infos);
+		vFileDialogInternal.puFilterManager.prFillFileStyle(vInfos);
 
-		prCompleteFileInfos(infos);
-		prFileList.push_back(infos);
+		prFileList.push_back(vInfos);
+	}
+
+	void IGFD::FileManager::AddFile(const FileDialogInternal& vFileDialogInternal, const std::string& vPath, const std::string& vFileName, const FileType& vFileType)
+	{
+		prAddFileInfos(vFileDialogInternal, prMakeFileInfos(vPath, vFileName, vFileType));
 	}
 
 	void IGFD::FileManager::AddPath(const FileDialogInternal& vFileDialogInternal, const std::string& vPath, const std::string& vFileName, const FileType& vFileType)
@@ -1644,6 +1708,19 @@ namespace IGFD
 		prPathList.push_back(infos);
 	}
 
+	// modification time of a directory in nanoseconds where the platform provides them (seconds otherwise), so that a
+	// change in the same second as a cached scan is still seen
+	static long long inModificationTime(const struct stat& vStatInfos)
+	{
+#if defined(__APPLE__)
+		return (long long)vStatInfos.st_mtimespec.tv_sec * 1000000000LL + vStatInfos.st_mtimespec.tv_nsec;
+#elif defined(_IGFD_UNIX_)
+		return (long long)vStatInfos.st_mtim.tv_sec * 1000000000LL + vStatInfos.st_mtim.tv_nsec;
+#else
+		return (long long)vStatInfos.st_mtime * 1000000000LL;
+#endif
+	}
+
 	void IGFD::FileManager::ScanDir(const FileDialogInternal& vFileDialogInternal, const std::string& vPath)
 	{
 		std::string	path = vPath;
@@ -1662,119 +1739,282 @@ namespace IGFD
 
 			ClearFileLists();
 
-#ifdef USE_STD_FILESYSTEM
-			try
+			// a scanned directory is reused while its modification time is unchanged
+			// (it changes when an entry is added, removed or renamed)
+			long long mtime = 0;
+			struct stat statInfos = {};
+			if (stat(path.c_str(), &statInfos) == 0)
+				mtime = inModificationTime(statInfos);
+
+			std::vector<std::shared_ptr<FileInfos>> cachedEntries;
+			bool cacheHit = false;
+			bool sameScan = false;
 			{
-				const std::filesystem::path fspath(path);
-				const auto dir_iter = std::filesystem::directory_iterator(fspath);
-				FileType fstype = FileType(FileType::ContentType::Directory, std::filesystem::is_symlink(std::filesystem::status(fspath)));
-				AddFile(vFileDialogInternal, path, "..", fstype);
-				for (const auto& file : dir_iter)
+				std::lock_guard<std::mutex> lock(prScanMutex);
+				auto it = prDirectoryCache.find(path);
+				if (it != prDirectoryCache.end())
 				{
-					FileType fileType;
-					if (file.is_symlink())
+					if (mtime != 0 && it->second.mtime == mtime)
 					{
-						fileType.SetSymLink(file.is_symlink());
-						fileType.SetContent(FileType::ContentType::LinkToUnknown);
+						cachedEntries = it->second.entries;
+						cacheHit = true;
 					}
-
-					if (file.is_directory()) { fileType.SetContent(FileType::ContentType::Directory); } // directory or symlink to directory
-					else if (file.is_regular_file()) { fileType.SetContent(FileType::ContentType::File); }
-
-					if (fileType.isValid())
+					else
 					{
-						auto fileNameExt = file.path().filename().string();
-						AddFile(vFileDialogInternal, path, fileNameExt, fileType);
+						prDirectoryCache.erase(it);
 					}
 				}
+				sameScan = prScan && prScan->running && prScan->path == path;
 			}
-			catch (const std::exception& ex)
+
+			if (sameScan) // the directory is already being scanned (ex. dialog closed and reopened), list it again from the start
 			{
-				printf("%s", ex.what());
+				prScanMerged = 0;
+				prScanActive = true;
+				return;
 			}
-#else // dirent
-			struct dirent** files = nullptr;
-			size_t n = scandir(path.c_str(), &files, nullptr, inAlphaSort);
-			if (n && files)
+
+			prCancelScan(); // directory change
+
+			if (cacheHit)
 			{
-				size_t i;
+				for (const auto& infos : cachedEntries)
+					prAddFileInfos(vFileDialogInternal, infos);
+				SortFields(vFileDialogInternal, prFileList, prFilteredFileList);
+				return;
+			}
 
-				for (i = 0; i < n; i++)
+			// enumerate and stat the entries on a worker, they are added to the list by UpdateScan
+			prScan = std::make_shared<ScanJob>();
+			prScan->path = path;
+			prScan->mtime = mtime;
+			prScanMerged = 0;
+			prScanActive = true;
+			prScanThread = std::thread(&IGFD::FileManager::prScanDirThread, this, prScan);
+		}
+	}
+
+	void IGFD::FileManager::prScanDirThread(std::shared_ptr<ScanJob> vJob)
+	{
+		const std::string& path = vJob->path;
+		const std::atomic<bool>& cancel = vJob->cancel;
+
+		// entries are published in batches, or after a short delay on slow (ex. network) file systems
+		std::vector<std::shared_ptr<FileInfos>> batch;
+		auto lastFlush = std::chrono::steady_clock::now();
+		auto flush = [this, &vJob, &batch, &lastFlush]()
+		{
+			std::lock_guard<std::mutex> lock(prScanMutex);
+			vJob->entries.insert(vJob->entries.end(), batch.begin(), batch.end());
+			batch.clear();
+			lastFlush = std::chrono::steady_clock::now();
+		};
+		auto add = [&](const std::string& vFileName, const FileType& vFileType)
+		{
+			batch.push_back(prMakeFileInfos(path, vFileName, vFileType));
+			if (batch.size() >= 256 || std::chrono::steady_clock::now() - lastFlush > std::chrono::milliseconds(50))
+				flush();
+		};
+
+#ifdef USE_STD_FILESYSTEM
+		try
+		{
+			const std::filesystem::path fspath(path);
+			const auto dir_iter = std::filesystem::directory_iterator(fspath);
+			FileType fstype = FileType(FileType::ContentType::Directory, std::filesystem::is_symlink(std::filesystem::status(fspath)));
+			add("..", fstype);
+			for (const auto& file : dir_iter)
+			{
+				if (cancel)
+					break;
+
+				FileType fileType;
+				if (file.is_symlink())
 				{
-					struct dirent* ent = files[i];
+					fileType.SetSymLink(file.is_symlink());
+					fileType.SetContent(FileType::ContentType::LinkToUnknown);
+				}
 
-					FileType fileType;
-					switch (ent->d_type)
-					{
-					case DT_DIR:
-						fileType.SetContent(FileType::ContentType::Directory); break;
-					case DT_REG:
-						fileType.SetContent(FileType::ContentType::File); break;
+				if (file.is_directory()) { fileType.SetContent(FileType::ContentType::Directory); } // directory or symlink to directory
+				else if (file.is_regular_file()) { fileType.SetContent(FileType::ContentType::File); }
+
+				if (fileType.isValid())
+				{
+					auto fileNameExt = file.path().filename().string();
+					add(fileNameExt, fileType);
+				}
+			}
+		}
+		catch (const std::exception& ex)
+		{
+			printf("%s", ex.what());
+		}
+#else // dirent
+		DIR* dir = opendir(path.c_str());
+		if (dir != nullptr)
+		{
+			struct dirent* ent = nullptr;
+			while (!cancel && (ent = readdir(dir)) != nullptr)
+			{
+				FileType fileType;
+				switch (ent->d_type)
+				{
+				case DT_DIR:
+					fileType.SetContent(FileType::ContentType::Directory); break;
+				case DT_REG:
+					fileType.SetContent(FileType::ContentType::File); break;
 #if DT_LNK != DT_UNKNOWN
-					case DT_LNK:
+				case DT_LNK:
+				{
+					fileType.SetSymLink(true);
+					fileType.SetContent(FileType::ContentType::LinkToUnknown); // by default if we can't figure out the target type.
+					struct stat statInfos = {};
+					int result = stat((path + PATH_SEP + ent->d_name).c_str(), &statInfos);
+					if (result == 0)
 					{
-						fileType.SetSymLink(true);
-						fileType.SetContent(FileType::ContentType::LinkToUnknown); // by default if we can't figure out the target type.
-						struct stat statInfos = {};
-						int result = stat((path + PATH_SEP + ent->d_name).c_str(), &statInfos);
-						if (result == 0)
+						if (statInfos.st_mode & S_IFREG)
 						{
-							if (statInfos.st_mode & S_IFREG)
-							{
-								fileType.SetContent(FileType::ContentType::File);
-							}
-							else if (statInfos.st_mode & S_IFDIR)
-							{
-								fileType.SetContent(FileType::ContentType::Directory);
-							}
+							fileType.SetContent(FileType::ContentType::File);
+						}
+						else if (statInfos.st_mode & S_IFDIR)
+						{
+							fileType.SetContent(FileType::ContentType::Directory);
 						}
-						break;
 					}
+					break;
+				}
 #endif
-					case DT_UNKNOWN: {
-						struct stat sb = {};
-						#ifdef _IGFD_WIN_
-						auto filePath = path + ent->d_name;
-						#else
-						auto filePath = path + std::string(1u, PATH_SEP) + ent->d_name;
-						#endif
-
-						int result = stat(filePath.c_str(), &sb);
-						if (result == 0) {
-							if (sb.st_mode & S_IFLNK) {
-								fileType.SetSymLink(true);
-								fileType.SetContent(FileType::ContentType::LinkToUnknown); // by default if we can't figure out the target type.
-							}
-							if (sb.st_mode & S_IFREG) {
-								fileType.SetContent(FileType::ContentType::File); break;
-							} else if (sb.st_mode & S_IFDIR) {
-								fileType.SetContent(FileType::ContentType::Directory); break;
-							}
+				case DT_UNKNOWN: {
+					struct stat sb = {};
+					#ifdef _IGFD_WIN_
+					auto filePath = path + ent->d_name;
+					#else
+					auto filePath = path + std::string(1u, PATH_SEP) + ent->d_name;
+					#endif
+
+					int result = stat(filePath.c_str(), &sb);
+					if (result == 0) {
+						if (sb.st_mode & S_IFLNK) {
+							fileType.SetSymLink(true);
+							fileType.SetContent(FileType::ContentType::LinkToUnknown); // by default if we can't figure out the target type.
+						}
+						if (sb.st_mode & S_IFREG) {
+							fileType.SetContent(FileType::ContentType::File); break;
+						} else if (sb.st_mode & S_IFDIR) {
+							fileType.SetContent(FileType::ContentType::Directory); break;
 						}
-						break;
-					}
-					default:
-						break; // leave it invalid (devices, etc.)
-					}
-
-					if (fileType.isValid())
-					{
-						auto fileNameExt = ent->d_name;
-						AddFile(vFileDialogInternal, path, fileNameExt, fileType);
 					}
+					break;
+				}
+				default:
+					break; // leave it invalid (devices, etc.)
 				}
 
-				for (i = 0; i < n; i++)
+				if (fileType.isValid())
 				{
-					free(files[i]);
+					add(ent->d_name, fileType);
 				}
-
-				free(files);
 			}
+
+			closedir(dir);
+		}
 #endif // USE_STD_FILESYSTEM
 
-			SortFields(vFileDialogInternal, prFileList, prFilteredFileList);
+		flush();
+
+		std::lock_guard<std::mutex> lock(prScanMutex);
+		if (!cancel) // complete listing : cache it
+		{
+			if (prDirectoryCache.size() >= DIRECTORY_CACHE_MAX_COUNT && prDirectoryCache.find(path) == prDirectoryCache.end())
+				prDirectoryCache.erase(prDirectoryCache.begin());
+			auto& cache = prDirectoryCache[path];
+			cache.mtime = vJob->mtime;
+			cache.entries = vJob->entries;
+		}
+		vJob->running = false;
+	}
+
+	void IGFD::FileManager::prCancelScan()
+	{
+		// the worker may be blocked in a slow stat (ex. network share) : it is not waited for here, it stops at its
+		// next entry and is joined by a later frame once it has exited
+		if (prScanThread.joinable())
+		{
+			prScan->cancel = true;
+			prCancelledScans.emplace_back(prScan, std::move(prScanThread));
+		}
+		prScan.reset();
+		prScanActive = false;
+		prJoinCancelledScans(false);
+	}
+
+	void IGFD::FileManager::prJoinCancelledScans(bool vWait)
+	{
+		for (auto it = prCancelledScans.begin(); it != prCancelledScans.end();)
+		{
+			bool running = false;
+			{
+				std::lock_guard<std::mutex> lock(prScanMutex);
+				running = it->first->running;
+			}
+			if (running && !vWait)
+			{
+				++it;
+				continue;
+			}
+			it->second.join(); // returns at once when the worker has already finished
+			it = prCancelledScans.erase(it);
+		}
+	}
+
+	bool IGFD::FileManager::UpdateScan(const FileDialogInternal& vFileDialogInternal)
+	{
+		if (!prCancelledScans.empty())
+			prJoinCancelledScans(false);
+
+		if (!prScanActive || !prScan)
+			return false;
+
+		std::vector<std::shared_ptr<FileInfos>> entries;
+		bool finished = false;
+		{
+			std::lock_guard<std::mutex> lock(prScanMutex);
+			entries.assign(prScan->entries.begin() + prScanMerged, prScan->entries.end());
+			prScanMerged = prScan->entries.size();
+			finished = !prScan->running;
 		}
+
+		size_t first = prFileList.size();
+		for (const auto& infos : entries)
+			prAddFileInfos(vFileDialogInternal, infos);
+
+		if (finished)
+		{
+			prScanActive = false;
+			if (prScanThread.joinable())
+				prScanThread.join();
+			SortFields(vFileDialogInternal, prFileList, prFilteredFileList); // sorted once, when the listing is complete
+			return true;
+		}
+
+		if (prFileList.size() > first)
+		{
+			// while the scan runs, new entries are filtered and appended in the order they are found
+			std::vector<std::shared_ptr<FileInfos>> added(prFileList.begin() + first, prFileList.end());
+			std::vector<std::shared_ptr<FileInfos>> shown;
+			ApplyFilteringOnFileList(vFileDialogInternal, added, shown);
+			prFilteredFileList.insert(prFilteredFileList.end(), shown.begin(), shown.end());
+			prFilteredSearchTag = vFileDialogInternal.puSearchManager.puSearchTag;
+			prFilteredSourceSize = prFileList.size();
+			return true;
+		}
+		return false;
+	}
+
+	size_t IGFD::FileManager::GetScannedCount()
+	{
+		std::lock_guard<std::mutex> lock(prScanMutex);
+		return prScan ? prScan->entries.size() : 0;
 	}
 
 #if defined(USE_QUICK_PATH_SELECT)
@@ -1986,9 +2226,27 @@ namespace IGFD
 		ClearComposer();
 		ClearFileLists();
 		ClearPathLists();
+		prScanActive = false; // a running scan goes on in the background and fills the cache
 	}
 	void IGFD::FileManager::ApplyFilteringOnFileList(const FileDialogInternal& vFileDialogInternal)
 	{
+		const auto& tag = vFileDialogInternal.puSearchManager.puSearchTag;
+
+		// when the search tag is extended (typing), the files it matches are a subset of the current result,
+		// so only the current result needs to be searched again
+		if (prFilteredSourceSize == prFileList.size() &&
+			!prFilteredSearchTag.empty() &&
+			tag.size() > prFilteredSearchTag.size() &&
+			tag.find(prFilteredSearchTag) != std::string::npos)
+		{
+			prFilteredFileList.erase(
+				std::remove_if(prFilteredFileList.begin(), prFilteredFileList.end(),
+					[&tag](const std::shared_ptr<FileInfos>& vInfos) { return !vInfos.use_count() || !vInfos->IsTagFound(tag); }),
+				prFilteredFileList.end());
+			prFilteredSearchTag = tag;
+			return;
+		}
+
 		ApplyFilteringOnFileList(vFileDialogInternal, prFileList, prFilteredFileList);
 	}
 
@@ -1998,6 +2256,7 @@ namespace IGFD
 		std::vector<std::shared_ptr<FileInfos>>& vFileInfosFilteredList)
 	{
 		vFileInfosFilteredList.clear();
+		vFileInfosFilteredList.reserve(vFileInfosList.size());
 		for (const auto& file : vFileInfosList)
 		{
 			if (!file.use_count())
@@ -2010,6 +2269,12 @@ namespace IGFD
 			if (show)
 				vFileInfosFilteredList.push_back(file);
 		}
+
+		if (&vFileInfosFilteredList == &prFilteredFileList) // can be narrowed by the next search (see ApplyFilteringOnFileList)
+		{
+			prFilteredSearchTag = vFileDialogInternal.puSearchManager.puSearchTag;
+			prFilteredSourceSize = vFileInfosList.size();
+		}
 	}
 
 	std::string IGFD::FileManager::prRoundNumber(double vvalue, int n)
@@ -2088,8 +2353,8 @@ namespace IGFD
 				errno_t err = localtime_s(&_tm, &statInfos.st_mtime);
 				if (!err) len = strftime(timebuf, 99, DateTimeFormat, &_tm);
 #else // _MSC_VER
-				struct tm* _tm = localtime(&statInfos.st_mtime);
-				if (_tm) len = strftime(timebuf, 99, DateTimeFormat, _tm);
+				struct tm _tm;
+				if (localtime_r(&statInfos.st_mtime, &_tm)) len = strftime(timebuf, 99, DateTimeFormat, &_tm); // called from the scan worker
 #endif // _MSC_VER
 				if (len)
 				{
@@ -2904,6 +3169,25 @@ namespace IGFD
 								stbi_image_free(datas);
 							}
 						}
+						else
+						{
+							// not an image, but an extractor may know this file type
+							const auto it = prExtractThumbnailFuns.find(file->fileExt);
+							if (it != prExtractThumbnailFuns.end())
+							{
+								auto fpn = file->filePath + std::string(1u, PATH_SEP) + file->fileNameExt;
+
+								auto th = &file->thumbnailInfo;
+								if (it->second(fpn, (int)DisplayMode_ThumbailsList_ImageHeight, th) && th->textureFileDatas)
+								{
+									// we set that at least, because will launch the gpu creation of the texture in the main thread
+									th->isReadyToUpload = true;
+
+									// need gpu loading
+									prAddThumbnailToCreate(file);
+								}
+							}
+						}
 					}
 
 					// peu importe le resultat on vire le fichicer
@@ -2962,6 +3246,7 @@ namespace IGFD
 					|| vFileInfos->fileExt == ".pic"
 					|| vFileInfos->fileExt == ".ppm" || vFileInfos->fileExt == ".pgm"
 					//|| file->fileExt == ".hdr" => format float so in few times
+					|| prExtractThumbnailFuns.find(vFileInfos->fileExt) != prExtractThumbnailFuns.end()
 					)
 				{
 					// write => thread concurency issues
@@ -3029,6 +3314,12 @@ namespace IGFD
 					if (file->thumbnailInfo.isReadyToDisplay) //-V522
 					{
 						prAddThumbnailToDestroy(file->thumbnailInfo);
+
+						// the entry can be shared with the directory cache, so it must not keep the texture that
+						// will be destroyed : the thumbnail is loaded again if the directory is displayed again
+						file->thumbnailInfo.textureID = nullptr;
+						file->thumbnailInfo.isReadyToDisplay = 0;
+						file->thumbnailInfo.isLoadingOrLoaded = 0;
 					}
 				}
 			}
@@ -3045,6 +3336,11 @@ namespace IGFD
 		prDestroyThumbnailFun = vCreateThumbnailFun;
 	}
 
+	void IGFD::ThumbnailFeature::AddThumbnailExtractor(const std::string& vExt, const ExtractThumbnailFun& vExtractThumbnailFun)
+	{
+		prExtractThumbnailFuns[vExt] = vExtractThumbnailFun;
+	}
+
 	void IGFD::ThumbnailFeature::ManageGPUThumbnails()
 	{
 		if (prCreateThumbnailFun)
@@ -3962,7 +4258,7 @@ namespace IGFD
 					fdFilter.SetDefaultFilterIfNotDefined();
 
 					// init list of files
-					if (fdFile.IsFileListEmpty() && !fdFile.puShowDrives)
+					if (fdFile.IsFileListEmpty() && !fdFile.puShowDrives && !fdFile.IsScanning())
 					{
 						IGFD::Utils::ReplaceString(fdFile.puDLGDefaultFileName, fdFile.puDLGpath, ""); // local path
 						if (!fdFile.puDLGDefaultFileName.empty())
@@ -3975,6 +4271,9 @@ namespace IGFD
 						fdFile.ScanDir(prFileDialogInternal, fdFile.puDLGpath);
 					}
 
+					// add the entries found by the directory scan since the last frame
+					fdFile.UpdateScan(prFileDialogInternal);
+
 					// draw dialog parts
 					prDrawHeader(); // bookmark, directory, path
 					prDrawContent(); // bookmark, files view, side pane
@@ -4070,6 +4369,12 @@ namespace IGFD
 #endif // USE_THUMBNAILS
 
 		prFileDialogInternal.puSearchManager.DrawSearchBar(prFileDialogInternal);
+
+		if (prFileDialogInternal.puFileManager.IsScanning())
+		{
+			ImGui::SameLine();
+			ImGui::Text("Scanning... %zu entries", prFileDialogInternal.puFileManager.GetScannedCount());
+		}
 	}
 
 	void IGFD::FileDialog::prDrawContent()
@@ -607,6 +607,17 @@ ImGuiFileDialog::Instance()->SetDestroyThumbnailCallback([](IGFD_Thumbnail_Info*
 ImGuiFileDialog::Instance()->ManageGPUThumbnails();
 ```
 
+Files that stb can't decode can have thumbnails too : register an extractor for their extension.
+It is called in the thumbnail thread and must fill textureFileDatas (allocated with new[], RGBA), textureWidth,
+textureHeight and textureChannels, then return true. vHeight is the height of the thumbnail to produce.
+
+```cpp
+ImGuiFileDialog::Instance()->AddThumbnailExtractor(".npy", [](const std::string& vFilePathName, int vHeight, IGFD_Thumbnail_Info* vThumbnail_Info) -> bool
+{
+	return MyVolumeThumbnail(vFilePathName, vHeight, vThumbnail_Info);
+});
+```
+
 ## Embedded in other frames :
 
 The dialog can be embedded in another user frame than the standard or modal dialog
@@ -922,6 +933,8 @@ struct IGFD_Thumbnail_Info
 #include <list>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <ctime>
 #include <regex>
 
 namespace IGFD
@@ -954,6 +967,10 @@ namespace IGFD
 #define MAX_PATH_BUFFER_SIZE 1024
 #endif // MAX_PATH_BUFFER_SIZE
 
+#ifndef DIRECTORY_CACHE_MAX_COUNT
+#define DIRECTORY_CACHE_MAX_COUNT 32
+#endif // DIRECTORY_CACHE_MAX_COUNT
+
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1184,6 +1201,8 @@ namespace IGFD
 		std::vector<std::string> prCurrentPathDecomposition;				// part words
 		std::vector<std::shared_ptr<FileInfos>> prFileList;					// base container
 		std::vector<std::shared_ptr<FileInfos>> prFilteredFileList;			// filtered container (search, sorting, etc..)
+		std::string prFilteredSearchTag;									// search tag prFilteredFileList was filtered with
+		size_t prFilteredSourceSize = 0;									// size of prFileList when prFilteredFileList was filtered
 		std::vector<std::shared_ptr<FileInfos>> prPathList;					// base container for path selection
 		std::vector<std::shared_ptr<FileInfos>> prFilteredPathList;			// filtered container for path selection (search, sorting, etc..)
 		std::vector<std::string>::iterator prPopupComposedPath;				// iterator on prCurrentPathDecomposition for Current Path popup
@@ -1191,6 +1210,27 @@ namespace IGFD
 		std::set<std::string> prSelectedFileNames;							// the user selection of FilePathNames
 		bool prCreateDirectoryMode = false;									// for create directory widget
 
+		struct DirectoryCache												// unfiltered entries of a scanned directory
+		{
+			long long mtime = 0;											// modification time of the directory when it was scanned (ns)
+			std::vector<std::shared_ptr<FileInfos>> entries;
+		};
+		struct ScanJob														// state shared with one scan worker (kept alive by a cancelled worker)
+		{
+			std::string path;												// directory scanned by the worker
+			long long mtime = 0;											// modification time of the directory when the scan started (ns)
+			std::atomic<bool> cancel{ false };								// request the worker to stop (directory change)
+			std::vector<std::shared_ptr<FileInfos>> entries;				// entries found so far (guarded by prScanMutex)
+			bool running = true;											// the worker has not finished yet (guarded by prScanMutex)
+		};
+		std::map<std::string, DirectoryCache> prDirectoryCache;				// scanned directories (guarded by prScanMutex)
+		std::mutex prScanMutex;												// guards the entries and state of the jobs and prDirectoryCache
+		std::shared_ptr<ScanJob> prScan;									// current scan (null if none)
+		std::thread prScanThread;											// worker of prScan
+		std::vector<std::pair<std::shared_ptr<ScanJob>, std::thread>> prCancelledScans;	// workers left to stop on their own, joined once they exit
+		size_t prScanMerged = 0;											// count of prScan->entries already added to the file list
+		bool prScanActive = false;											// the file list is being filled from the worker
+
 	public:
 		char puVariadicBuffer[MAX_FILE_DIALOG_NAME_BUFFER] = "";			// called by prSelectableItem
 		bool puInputPathActivated = false;									// show input for path edition
@@ -1232,6 +1272,13 @@ namespace IGFD
 		static std::string prRoundNumber(double vvalue, int n);											// custom rounding number
 		static std::string prFormatFileSize(size_t vByteSize);											// format file size field
 		static void prCompleteFileInfos(const std::shared_ptr<FileInfos>& FileInfos);					// set time and date infos of a file (detail view mode)
+		static std::shared_ptr<FileInfos> prMakeFileInfos(
+			const std::string& vPath, const std::string& vFileName, const FileType& vFileType);		// unfiltered infos of a file (thread safe)
+		void prAddFileInfos(const FileDialogInternal& vFileDialogInternal,
+			const std::shared_ptr<FileInfos>& vInfos);													// add infos to the file list if the filters accept them
+		void prScanDirThread(std::shared_ptr<ScanJob> vJob);											// worker : enumerate a directory into vJob->entries
+		void prCancelScan();																			// ask the worker to stop without waiting for it
+		void prJoinCancelledScans(bool vWait);															// join the cancelled workers that have exited (or all of them)
 		void prRemoveFileNameInSelection(const std::string& vFileName);									// selection : remove a file name
 		void prAddFileNameInSelection(const std::string& vFileName, bool vSetLastSelectionFileName);	// selection : add a file name
 		void AddFile(const FileDialogInternal& vFileDialogInternal, 
@@ -1257,6 +1304,7 @@ namespace IGFD
 		
 	public:
 		FileManager();
+		~FileManager();
 		bool IsComposerEmpty();
 		size_t GetComposerSize();
 		bool IsFileListEmpty();
@@ -1293,7 +1341,10 @@ namespace IGFD
 		
 		//depend of dirent.h
 		void SetCurrentDir(const std::string& vPath);													// define current directory for scan
-		void ScanDir(const FileDialogInternal& vFileDialogInternal, const std::string& vPath);			// scan the directory for retrieve the file list
+		void ScanDir(const FileDialogInternal& vFileDialogInternal, const std::string& vPath);			// scan the directory for retrieve the file list (asynchronous, see UpdateScan)
+		bool UpdateScan(const FileDialogInternal& vFileDialogInternal);									// add the entries found by the scan since the last call, true if the list changed
+		bool IsScanning() const { return prScanActive; }												// the file list is still being filled
+		size_t GetScannedCount();																		// entries found so far by the running scan
 		
 	public:
 		std::string GetResultingPath();
@@ -1313,6 +1364,7 @@ namespace IGFD
 #ifdef USE_THUMBNAILS
 	typedef std::function<void(IGFD_Thumbnail_Info*)> CreateThumbnailFun;	// texture 2d creation function binding
 	typedef std::function<void(IGFD_Thumbnail_Info*)> DestroyThumbnailFun;	// texture 2d destroy function binding
+	typedef std::function<bool(const std::string&, int, IGFD_Thumbnail_Info*)> ExtractThumbnailFun;	// thumbnail datas extraction function binding (file path name, height)
 #endif
 	class ThumbnailFeature
 	{
@@ -1346,6 +1398,7 @@ namespace IGFD
 
 		CreateThumbnailFun prCreateThumbnailFun = nullptr;
 		DestroyThumbnailFun prDestroyThumbnailFun = nullptr;
+		std::map<std::string, ExtractThumbnailFun> prExtractThumbnailFuns;	// extractors of non image files, by file extension
 
 	protected:
 		DisplayModeEnum prDisplayMode = DisplayModeEnum::FILE_LIST;
@@ -1365,6 +1418,7 @@ namespace IGFD
 	public:
 		void SetCreateThumbnailCallback(const CreateThumbnailFun& vCreateThumbnailFun);
 		void SetDestroyThumbnailCallback(const DestroyThumbnailFun& vCreateThumbnailFun);
+		void AddThumbnailExtractor(const std::string& vExt, const ExtractThumbnailFun& vExtractThumbnailFun);	// must be set before the dialog is opened, called in the thumbnail thread
 		
 		// must be call in gpu zone (rendering, possibly one rendering thread)
 		void ManageGPUThumbnails();	// in gpu rendering zone, whill create or destroy texture
@@ -0,0 +1,126 @@
+#include "metadata.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+/// <summary>
+/// Find "key" in the JSON text and return the position just after the following ':' (or npos)
+/// </summary>
+static size_t FindValue(const std::string& json, const std::string& key) {
+    size_t p = json.find("\"" + key + "\"");
+    if (p == std::string::npos) return p;
+    p = json.find(':', p + key.size() + 2);
+    return (p == std::string::npos) ? p : p + 1;
+}
+
+bool JsonNumbers(const std::string& json, const std::string& key, float* values, int n) {
+    size_t p = FindValue(json, key);
+    if (p == std::string::npos) return false;
+    p = json.find('[', p);
+    if (p == std::string::npos) return false;
+
+    const char* s = json.c_str() + p + 1;
+    std::vector<float> result(n);
+    for (int i = 0; i < n; i++) {
+        char* end;
+        result[i] = (float)strtod(s, &end);
+        if (end == s) return false;
+        s = end;
+        while (*s == ' ' || *s == ',' || *s == '\t' || *s == '\n' || *s == '\r') s++;
+    }
+    std::copy(result.begin(), result.end(), values);
+    return true;
+}
+
+bool JsonNumber(const std::string& json, const std::string& key, float& value) {
+    size_t p = FindValue(json, key);
+    if (p == std::string::npos) return false;
+    const char* s = json.c_str() + p;
+    while (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r') s++;
+    if (strncmp(s, "true", 4) == 0 || strncmp(s, "false", 5) == 0) {
+        value = (*s == 't') ? 1.0f : 0.0f;
+        return true;
+    }
+    char* end;
+    float result = (float)strtod(s, &end);
+    if (end == s) return false;
+    value = result;
+    return true;
+}
+
+bool JsonString(const std::string& json, const std::string& key, std::string& value) {
+    size_t p = FindValue(json, key);
+    if (p == std::string::npos) return false;
+    size_t begin = json.find('"', p);
+    if (begin == std::string::npos) return false;
+
+    std::string result;
+    for (size_t i = begin + 1; i < json.size(); i++) {
+        if (json[i] == '"') {
+            value = result;
+            return true;
+        }
+        if (json[i] == '\\' && i + 1 < json.size()) i++;  // \" and \\ (the only escapes written by JsonEscape)
+        result += json[i];
+    }
+    return false;
+}
+
+std::string JsonEscape(const std::string& text) {
+    std::string result;
+    for (char c : text) {
+        if (c == '"' || c == '\\') result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+bool ParseVolumeMetadata(const std::string& json, VolumeMetadata& meta) {
+    bool found = false;
+    found |= JsonNumbers(json, "spacing", &meta.spacing[0], 3);
+    found |= JsonNumbers(json, "origin", &meta.origin[0], 3);
+    found |= JsonString(json, "units", meta.units);
+
+    for (int i = 0; i < 3; i++) {
+        if (!(meta.spacing[i] > 0.0f)) {
+            std::cout << "WARNING: invalid voxel spacing in metadata, using 1.0" << std::endl;
+            meta.spacing[i] = 1.0f;
+        }
+    }
+    meta.loaded = found;
+    return found;
+}
+
+bool LoadVolumeMetadata(std::string volume_path, VolumeMetadata& meta, bool verbose) {
+    meta = VolumeMetadata();
+    std::string candidates[2] = { volume_path + ".json", volume_path.substr(0, volume_path.find_last_of('.')) + ".json" };
+    for (const std::string& filename : candidates) {
+        std::ifstream in(filename);
+        if (!in) continue;
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        if (ParseVolumeMetadata(buffer.str(), meta)) {
+            if (verbose) std::cout << "Voxel spacing (" << meta.spacing.x << ", " << meta.spacing.y << ", " << meta.spacing.z << ") "
+                << meta.units << " read from " << filename << std::endl;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SaveVolumeMetadata(std::string filename, const VolumeMetadata& meta) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cout << "ERROR: unable to write " << filename << std::endl;
+        return false;
+    }
+    out << "{ \"spacing\": [" << meta.spacing.x << ", " << meta.spacing.y << ", " << meta.spacing.z << "], "
+        << "\"origin\": [" << meta.origin.x << ", " << meta.origin.y << ", " << meta.origin.z << "], "
+        << "\"units\": \"" << JsonEscape(meta.units) << "\" }" << std::endl;
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+
+/// <summary>
+/// Physical description of a volume: voxel spacing, the position of voxel (0, 0, 0) and the unit of both
+/// </summary>
+struct VolumeMetadata {
+    bool loaded = false;                                // true if the values were read from a file (otherwise defaults)
+    glm::vec3 spacing = glm::vec3(1.0f);                // physical size of a voxel along x, y, z
+    glm::vec3 origin = glm::vec3(0.0f);                 // physical position of the center of voxel (0, 0, 0)
+    std::string units = "px";
+};
+
+/// <summary>
+/// Look for a JSON sidecar next to a volume file and read its spacing, origin and units. Both
+/// "volume.npy.json" and "volume.json" are accepted, for example:
+///     { "spacing": [0.3, 0.3, 2.0], "origin": [0, 0, 0], "units": "um" }
+/// Keys that are missing keep their default values.
+/// </summary>
+/// <param name="verbose">Report the values that were read on the console</param>
+/// <returns>true if a sidecar was found and parsed</returns>
+bool LoadVolumeMetadata(std::string volume_path, VolumeMetadata& meta, bool verbose = true);
+
+/// <summary>
+/// Parse metadata from the text of a JSON sidecar (see LoadVolumeMetadata)
+/// </summary>
+bool ParseVolumeMetadata(const std::string& json, VolumeMetadata& meta);
+
+/// <summary>
+/// Write a JSON sidecar (in the format read by LoadVolumeMetadata)
+/// </summary>
+bool SaveVolumeMetadata(std::string filename, const VolumeMetadata& meta);
+
+/// <summary>
+/// Minimal readers for the flat JSON files written by the viewer (sidecars and sessions): the first occurrence of
+/// "key" is located anywhere in the text and its value is parsed. They return false (and leave the output unchanged)
+/// if the key is missing or its value has the wrong type.
+/// </summary>
+bool JsonNumber(const std::string& json, const std::string& key, float& value);               // number or true/false
+bool JsonNumbers(const std::string& json, const std::string& key, float* values, int n);      // array of n numbers
+bool JsonString(const std::string& json, const std::string& key, std::string& value);
+
+/// <summary>
+/// Escape quotes and backslashes (ex. Windows paths) so that text can be written as a JSON string
+/// </summary>
+std::string JsonEscape(const std::string& text);
@@ -0,0 +1,79 @@
+#include "minmax.h"
+#include "parallel.h"
+
+void MinMaxGrid::Build(const VoxelGrid& g, size_t brick_size) {
+    Clear();
+    if (!g.data || g.X == 0 || g.Y == 0 || g.Z == 0) return;
+    brick = brick_size;
+    channels = g.C;
+    dims = glm::ivec3((int)g.X, (int)g.Y, (int)g.Z);
+    nbricks = glm::ivec3((int)((g.X + brick - 1) / brick), (int)((g.Y + brick - 1) / brick), (int)((g.Z + brick - 1) / brick));
+    lower.assign(Count() * channels, 255);
+    upper.assign(Count() * channels, 0);
+    bins.assign(Count() * channels, 0);
+
+    parallel_for(Count(), [&](size_t begin, size_t end) {
+        std::vector<uint32_t> histogram(256 * channels);
+        for (size_t b = begin; b < end; b++) {
+            glm::ivec3 o = Origin(b);
+            size_t x1 = std::min(o.x + brick, g.X - 1), y1 = std::min(o.y + brick, g.Y - 1), z1 = std::min(o.z + brick, g.Z - 1);
+            size_t n = (x1 - o.x + 1) * channels;       // values per row
+
+            // a byte histogram per channel is cheaper to fill than tracking min, max and bins per voxel
+            std::fill(histogram.begin(), histogram.end(), 0);
+            for (size_t z = o.z; z <= z1; z++)
+                for (size_t y = o.y; y <= y1; y++) {
+                    const unsigned char* p = g.voxel(o.x, y, z);
+                    for (size_t i = 0; i < n; i += channels)
+                        for (size_t c = 0; c < channels; c++) histogram[c * 256 + p[i + c]]++;
+                }
+
+            for (size_t c = 0; c < channels; c++) {
+                const uint32_t* h = &histogram[c * 256];
+                int lo = 0, hi = 255;
+                while (lo < 255 && h[lo] == 0) lo++;
+                while (hi > 0 && h[hi] == 0) hi--;
+                uint16_t mask = 0;
+                for (int v = lo; v <= hi; v++)
+                    if (h[v]) mask |= (uint16_t)(1u << (v / 16));
+                lower[b * channels + c] = (unsigned char)lo;
+                upper[b * channels + c] = (unsigned char)hi;
+                bins[b * channels + c] = mask;
+            }
+        }
+    });
+}
+
+void MinMaxGrid::Clear() {
+    lower.clear();
+    upper.clear();
+    bins.clear();
+    nbricks = glm::ivec3(0);
+    dims = glm::ivec3(0);
+    channels = 0;
+}
+
+GLuint MinMaxGrid::Upload(size_t channel) {
+    if (Empty() || channel >= channels) return 0;
+    std::vector<unsigned char> texels(Count() * 2);
+    for (size_t b = 0; b < Count(); b++) {
+        texels[2 * b + 0] = Min(b, channel);
+        texels[2 * b + 1] = Max(b, channel);
+    }
+    if (!texture) glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RG8, nbricks.x, nbricks.y, nbricks.z, 0, GL_RG, GL_UNSIGNED_BYTE, texels.data());
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    return texture;
+}
+
+void MinMaxGrid::Destroy() {
+    if (texture) glDeleteTextures(1, &texture);
+    texture = 0;
+}
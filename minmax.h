@@ -0,0 +1,69 @@
+#pragma once
+
+#include "tira/graphics_gl.h"
+#include "reslice.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#define MINMAX_BRICK 32                                 // default edge length (in voxels) of a brick
+
+/// <summary>
+/// Coarse acceleration structure over a volume: the value range of every brick of voxels and a 16-bin summary of
+/// the values it contains. A brick also covers the first layer of voxels of the next brick, so the range is
+/// conservative for the cells (voxel cubes) inside the brick, which is what isosurfacing and raycasting need.
+/// Built once per volume (in parallel) and queried by the CPU tools; the ranges of one channel can be uploaded as
+/// an RG8 3D texture for use in shaders.
+/// </summary>
+class MinMaxGrid {
+    size_t brick = MINMAX_BRICK;
+    glm::ivec3 nbricks = glm::ivec3(0);
+    size_t channels = 0;
+    glm::ivec3 dims = glm::ivec3(0);                    // size of the volume in voxels
+    std::vector<unsigned char> lower, upper;            // per brick and channel (channel fastest)
+    std::vector<uint16_t> bins;                         // bit k is set if a value in [16k, 16k + 15] is present
+    GLuint texture = 0;
+
+public:
+    /// <summary>
+    /// Compute the ranges of all bricks of a volume
+    /// </summary>
+    void Build(const VoxelGrid& grid, size_t brick_size = MINMAX_BRICK);
+    void Clear();
+
+    bool Empty() const { return lower.empty(); }
+    size_t BrickSize() const { return brick; }
+    glm::ivec3 Bricks() const { return nbricks; }
+    size_t Count() const { return (size_t)nbricks.x * nbricks.y * nbricks.z; }
+    size_t Channels() const { return channels; }
+    bool Matches(const VoxelGrid& g) const {            // true if the grid was built for a volume of this shape
+        return !Empty() && channels == g.C && dims.x == (int)g.X && dims.y == (int)g.Y && dims.z == (int)g.Z;
+    }
+
+    size_t Index(int bx, int by, int bz) const { return ((size_t)bz * nbricks.y + by) * nbricks.x + bx; }
+    glm::ivec3 Origin(size_t b) const {                 // first voxel of brick b
+        return glm::ivec3((int)((b % nbricks.x) * brick), (int)(((b / nbricks.x) % nbricks.y) * brick), (int)((b / ((size_t)nbricks.x * nbricks.y)) * brick));
+    }
+    unsigned char Min(size_t b, size_t c) const { return lower[b * channels + c]; }
+    unsigned char Max(size_t b, size_t c) const { return upper[b * channels + c]; }
+
+    /// <summary>
+    /// Returns false if no voxel of brick b has a value in [lo, hi] in channel c (true means it may)
+    /// </summary>
+    bool MayContain(size_t b, size_t c, int lo, int hi) const {
+        if (hi < Min(b, c) || lo > Max(b, c) || lo > hi) return false;
+        int first = std::max(lo, 0) / 16, last = std::min(hi, 255) / 16;
+        uint16_t mask = (uint16_t)(((2u << last) - 1) & ~((1u << first) - 1));
+        return (bins[b * channels + c] & mask) != 0;
+    }
+
+    /// <summary>
+    /// Upload the ranges of one channel as an RG8 3D texture (min in red, max in green, one texel per brick)
+    /// </summary>
+    GLuint Upload(size_t channel = 0);
+    GLuint Texture() const { return texture; }
+    size_t HostBytes() const { return lower.size() + upper.size() + bins.size() * sizeof(uint16_t); }
+    size_t GpuBytes() const { return texture ? Count() * 2 : 0; }      // RG8 texture
+    void Destroy();                                     // release the texture (requires a current context)
+};
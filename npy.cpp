@@ -0,0 +1,121 @@
+#include "npy.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+bool ReadNpyHeader(std::string filename, NpyHeader& header) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) return false;
+
+    // magic string, version and header length
+    unsigned char preamble[12];
+    in.read((char*)preamble, 10);
+    if (!in || memcmp(preamble, "\x93NUMPY", 6) != 0) return false;
+    size_t header_len;
+    size_t preamble_len;
+    if (preamble[6] == 1) {
+        header_len = preamble[8] | (preamble[9] << 8);
+        preamble_len = 10;
+    }
+    else {                                              // versions 2 and 3 use a 4-byte header length
+        in.read((char*)preamble + 10, 2);
+        header_len = preamble[8] | (preamble[9] << 8) | (preamble[10] << 16) | ((size_t)preamble[11] << 24);
+        preamble_len = 12;
+    }
+    if (header_len > 1 << 20) return false;
+
+    std::string dict(header_len, '\0');
+    in.read(&dict[0], header_len);
+    if (!in) return false;
+    header.offset = preamble_len + header_len;
+
+    // 'descr': '<u2'
+    size_t p = dict.find("'descr'");
+    if (p == std::string::npos) return false;
+    size_t q0 = dict.find('\'', p + 7);
+    size_t q1 = dict.find('\'', q0 + 1);
+    if (q0 == std::string::npos || q1 == std::string::npos) return false;
+    header.descr = dict.substr(q0 + 1, q1 - q0 - 1);
+    if (header.descr.size() < 3) return false;
+    header.kind = header.descr[1];
+    header.itemsize = (size_t)atoi(header.descr.c_str() + 2);
+    if (header.descr[0] == '>' && header.itemsize > 1) return false;   // big-endian data is not supported
+
+    // 'fortran_order': False
+    p = dict.find("'fortran_order'");
+    if (p != std::string::npos) {
+        size_t v = dict.find_first_of("TF", p + 15);
+        header.fortran_order = (v != std::string::npos && dict[v] == 'T');
+    }
+
+    // 'shape': (Z, Y, X, ...)
+    p = dict.find("'shape'");
+    if (p == std::string::npos) return false;
+    size_t open = dict.find('(', p);
+    size_t close = dict.find(')', open);
+    if (open == std::string::npos || close == std::string::npos) return false;
+    header.shape.clear();
+    const char* s = dict.c_str() + open + 1;
+    const char* end = dict.c_str() + close;
+    while (s < end) {
+        char* next;
+        unsigned long long v = strtoull(s, &next, 10);
+        if (next == s) { s++; continue; }
+        header.shape.push_back((size_t)v);
+        s = next;
+    }
+    return true;
+}
+
+template<typename T>
+static void ConvertArray(const void* src, size_t n, float* dst) {
+    const T* s = (const T*)src;
+    for (size_t i = 0; i < n; i++)                      // simple loop, vectorized by the compiler
+        dst[i] = (float)s[i];
+}
+
+bool NpyToFloat(const NpyHeader& header, const void* src, size_t n, float* dst) {
+    switch (header.kind) {
+    case 'b':
+    case 'u':
+        if (header.itemsize == 1) ConvertArray<uint8_t>(src, n, dst);
+        else if (header.itemsize == 2) ConvertArray<uint16_t>(src, n, dst);
+        else if (header.itemsize == 4) ConvertArray<uint32_t>(src, n, dst);
+        else if (header.itemsize == 8) ConvertArray<uint64_t>(src, n, dst);
+        else return false;
+        return true;
+    case 'i':
+        if (header.itemsize == 1) ConvertArray<int8_t>(src, n, dst);
+        else if (header.itemsize == 2) ConvertArray<int16_t>(src, n, dst);
+        else if (header.itemsize == 4) ConvertArray<int32_t>(src, n, dst);
+        else if (header.itemsize == 8) ConvertArray<int64_t>(src, n, dst);
+        else return false;
+        return true;
+    case 'f':
+        if (header.itemsize == 4) ConvertArray<float>(src, n, dst);
+        else if (header.itemsize == 8) ConvertArray<double>(src, n, dst);
+        else return false;
+        return true;
+    }
+    return false;
+}
+
+std::string MakeNpyHeader(std::string descr, const std::vector<size_t>& shape) {
+    std::string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': (";
+    for (size_t i = 0; i < shape.size(); i++)
+        dict += std::to_string(shape[i]) + ((shape.size() == 1 || i + 1 < shape.size()) ? ", " : "");
+    dict += "), }";
+
+    size_t total = 10 + dict.size() + 1;                // preamble + dictionary + newline
+    dict.append((64 - total % 64) % 64, ' ');
+    dict += '\n';
+
+    std::string header = "\x93NUMPY";
+    header += (char)1;
+    header += (char)0;
+    header += (char)(dict.size() & 0xff);
+    header += (char)((dict.size() >> 8) & 0xff);
+    return header + dict;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Description of a NumPy (*.npy) file parsed from its header
+/// </summary>
+struct NpyHeader {
+    std::string descr;                                  // NumPy type string (ex. "<u2")
+    bool fortran_order = false;
+    std::vector<size_t> shape;
+    size_t offset = 0;                                  // byte offset of the array data within the file
+    size_t itemsize = 0;                                // size of one element in bytes
+    char kind = 0;                                      // 'u' (unsigned), 'i' (signed), 'f' (floating point), 'b' (bool)
+
+    size_t count() const {                              // number of elements in the array
+        size_t n = 1;
+        for (size_t s : shape) n *= s;
+        return n;
+    }
+    size_t bytes() const { return count() * itemsize; }
+};
+
+/// <summary>
+/// Read and parse the header of a NumPy file without touching the array data (reads at most a few KB)
+/// </summary>
+/// <returns>false if the file cannot be opened or is not a valid NumPy file</returns>
+bool ReadNpyHeader(std::string filename, NpyHeader& header);
+
+/// <summary>
+/// Convert n elements of an array (stored in the type described by the header) to floating point
+/// </summary>
+/// <returns>false if the data type is not supported (8 to 64-bit integers, 32 and 64-bit floats and bool are)</returns>
+bool NpyToFloat(const NpyHeader& header, const void* src, size_t n, float* dst);
+
+/// <summary>
+/// Build the header of a C-order NumPy file (version 1.0, padded so that the array data is 64-byte aligned)
+/// </summary>
+/// <param name="descr">NumPy type string (ex. "|u1")</param>
+/// <param name="shape">Array shape, slowest dimension first</param>
+std::string MakeNpyHeader(std::string descr, const std::vector<size_t>& shape);
@@ -0,0 +1,72 @@
+#include "overlay.h"
+
+#include <iostream>
+
+bool OverlayStack::Add(std::string name, const unsigned char* data, size_t X, size_t Y, size_t Z, size_t C) {
+    if (layers.size() >= MAX_OVERLAYS) {
+        std::cout << "ERROR: a maximum of " << MAX_OVERLAYS << " overlays can be loaded" << std::endl;
+        return false;
+    }
+    if (C < 1 || C > 4) {
+        std::cout << "ERROR: overlays must have 1 - 4 channels (" << name << " has " << C << ")" << std::endl;
+        return false;
+    }
+    OverlayLayer layer;
+    layer.name = name;
+    layer.X = X;
+    layer.Y = Y;
+    layer.Z = Z;
+    layer.C = C;
+    layer.colormap = (C == 1) ? (int)(COLORMAP_RED + layers.size() % 4) : COLORMAP_NATIVE;  // distinct default color per channel
+
+    const GLenum formats[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+    const GLint internal_formats[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+    glGenTextures(1, &layer.texture);
+    glBindTexture(GL_TEXTURE_3D, layer.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_3D, 0, internal_formats[C - 1], (GLsizei)X, (GLsizei)Y, (GLsizei)Z, 0, formats[C - 1], GL_UNSIGNED_BYTE, data);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    layers.push_back(layer);
+    return true;
+}
+
+void OverlayStack::Remove(size_t i) {
+    if (i >= layers.size()) return;
+    glDeleteTextures(1, &layers[i].texture);
+    layers.erase(layers.begin() + i);
+}
+
+void OverlayStack::Clear() {
+    while (!layers.empty()) Remove(layers.size() - 1);
+}
+
+size_t OverlayStack::Bytes() const {
+    size_t total = 0;
+    for (const OverlayLayer& layer : layers) total += layer.bytes();
+    return total;
+}
+
+void OverlayStack::Bind(glProgram* shader) {
+    int count = 0;
+    for (size_t i = 0; i < layers.size(); i++) {
+        const OverlayLayer& layer = layers[i];
+        if (!layer.visible) continue;
+        std::string n = std::to_string(count);
+        glActiveTexture(GL_TEXTURE1 + count);
+        glBindTexture(GL_TEXTURE_3D, layer.texture);
+        shader->SetUniform1i("overlay" + n, 1 + count);
+        shader->SetUniform1i("overlay_colormap" + n, layer.colormap);
+        shader->SetUniform1i("overlay_blend" + n, layer.blend);
+        shader->SetUniform1i("overlay_channels" + n, (int)layer.C);
+        shader->SetUniform1f("overlay_opacity" + n, layer.opacity);
+        count++;
+    }
+    glActiveTexture(GL_TEXTURE0);
+    shader->SetUniform1i("overlay_count", count);
+}
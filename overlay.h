@@ -0,0 +1,54 @@
+#pragma once
+
+#include "tira/graphics_gl.h"
+#include "program.h"
+
+#include <string>
+#include <vector>
+
+#define MAX_OVERLAYS 4                                  // number of overlay samplers in the slicer shader (texture units 1 - 4)
+
+enum OverlayColormap { COLORMAP_NATIVE = 0, COLORMAP_RED, COLORMAP_GREEN, COLORMAP_BLUE, COLORMAP_MAGENTA, COLORMAP_HOT };
+enum OverlayBlend { BLEND_ALPHA = 0, BLEND_ADD, BLEND_MAX };
+
+/// <summary>
+/// A volume that is composited on top of the primary volume in the slicer shader
+/// </summary>
+struct OverlayLayer {
+    std::string name;
+    std::string path;                                   // file the overlay was read from (saved in sessions)
+    GLuint texture = 0;                                 // 3D texture holding the overlay
+    size_t X = 0, Y = 0, Z = 0, C = 1;                  // size of the overlay in voxels (and number of channels)
+    int colormap = COLORMAP_RED;                        // applied to the intensity of single-channel overlays
+    int blend = BLEND_ADD;
+    float opacity = 1.0f;
+    bool visible = true;
+
+    size_t bytes() const { return X * Y * Z * C; }
+};
+
+/// <summary>
+/// Set of overlay volumes sampled in the same fragment shader pass as the primary volume, so adding a channel
+/// costs texture fetches rather than an additional draw per plane. The memory of the overlays is checked against
+/// the viewer's MemoryBudget by the caller before they are read.
+/// </summary>
+class OverlayStack {
+    std::vector<OverlayLayer> layers;
+
+public:
+    /// <summary>
+    /// Upload a volume as a new overlay. Fails if MAX_OVERLAYS are already loaded.
+    /// </summary>
+    bool Add(std::string name, const unsigned char* data, size_t X, size_t Y, size_t Z, size_t C);
+    void Remove(size_t i);
+    void Clear();
+
+    size_t size() const { return layers.size(); }
+    OverlayLayer& operator[](size_t i) { return layers[i]; }
+    size_t Bytes() const;                               // total size of all overlays
+
+    /// <summary>
+    /// Bind the overlay textures to texture units 1 - MAX_OVERLAYS and set the overlay uniforms of the slicer shader
+    /// </summary>
+    void Bind(glProgram* shader);
+};
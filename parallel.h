@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Fixed-size pool of worker threads that execute queued tasks in FIFO order. Used to overlap CPU-side
+/// work (image encoding, file I/O) with rendering on the main (OpenGL) thread.
+/// </summary>
+class WorkerPool {
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex m;
+    std::condition_variable task_cv;                    // signaled when a task is queued (or the pool is stopping)
+    std::condition_variable done_cv;                    // signaled when a task completes
+    size_t active = 0;                                  // number of tasks currently executing
+    bool stopping = false;
+
+    void run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                task_cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop();
+                active++;
+            }
+            task();
+            task = nullptr;                             // release the captures (ex. buffers) before the task counts as done
+            {
+                std::lock_guard<std::mutex> lock(m);
+                active--;
+            }
+            done_cv.notify_all();
+        }
+    }
+
+public:
+    /// <param name="n">Number of worker threads (0 uses the hardware concurrency)</param>
+    WorkerPool(size_t n = 0) {
+        if (n == 0) n = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < n; i++)
+            workers.emplace_back(&WorkerPool::run, this);
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        task_cv.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+
+    size_t size() const { return workers.size(); }
+
+    /// <summary>
+    /// Queue a task for execution on one of the worker threads
+    /// </summary>
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            tasks.push(std::move(task));
+        }
+        task_cv.notify_one();
+    }
+
+    /// <summary>
+    /// Block until fewer than n tasks are queued or executing (used to bound the memory held by in-flight work)
+    /// </summary>
+    void wait_below(size_t n) {
+        std::unique_lock<std::mutex> lock(m);
+        done_cv.wait(lock, [this, n] { return tasks.size() + active < n; });
+    }
+
+    /// <summary>
+    /// Block until all submitted tasks have completed
+    /// </summary>
+    void wait() { wait_below(1); }
+};
+
+/// <summary>
+/// Splits the range [0, n) into contiguous blocks and calls f(begin, end) for each block on its own thread.
+/// The calling thread processes the first block.
+/// </summary>
+template<typename F>
+void parallel_for(size_t n, F f, size_t min_block = 1) {
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, std::max<size_t>(1, n / std::max<size_t>(1, min_block)));
+    if (threads <= 1) {
+        if (n > 0) f((size_t)0, n);
+        return;
+    }
+    size_t block = (n + threads - 1) / threads;
+    std::vector<std::thread> pool;
+    for (size_t b = block; b < n; b += block)
+        pool.emplace_back([=, &f] { f(b, std::min(n, b + block)); });
+    f((size_t)0, std::min(n, block));
+    for (std::thread& t : pool) t.join();
+}
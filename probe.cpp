@@ -0,0 +1,92 @@
+#include "probe.h"
+
+#include <iostream>
+
+static std::string PickVertexSource =
+"# version 330 core\n"
+"void main()\n"
+"{\n"
+"    gl_Position = vec4(0.0, 0.0, 0.0, 1.0);\n"
+"};\n";
+
+static std::string PickFragmentSource =
+"# version 330 core\n"
+"uniform int integer_source;\n"
+"uniform ivec3 voxel;\n"
+"uniform sampler3D floatTexture;\n"
+"uniform usampler3D uintTexture;\n"
+"out uvec4 value;\n"
+"void main()\n"
+"{\n"
+"    if (integer_source == 1) value = texelFetch(uintTexture, voxel, 0);\n"
+"    else value = uvec4(texelFetch(floatTexture, voxel, 0) * 255.0 + 0.5);\n"
+"};\n";
+
+#define PICK_FLOAT_UNIT 6
+#define PICK_UINT_UNIT 7
+
+void glPicker::Destroy() {
+    if (fbo) glDeleteFramebuffers(1, &fbo);
+    if (color) glDeleteRenderbuffers(1, &color);
+    if (vao) glDeleteVertexArrays(1, &vao);
+    delete shader;
+    fbo = color = vao = 0;
+    shader = nullptr;
+}
+
+bool glPicker::Init() {
+    if (fbo) return true;
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA32UI, 1, 1);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLint bound;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bound);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, bound);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "ERROR: voxel pick framebuffer is incomplete" << std::endl;
+        return false;
+    }
+
+    glGenVertexArrays(1, &vao);
+    shader = new glProgram(PickVertexSource, PickFragmentSource);
+    return true;
+}
+
+bool glPicker::Pick(GLuint texture, bool integer, glm::ivec3 voxel, unsigned int* out) {
+    if (!texture || !Init()) return false;
+
+    GLint bound, viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bound);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, 1, 1);
+    glDisable(GL_DEPTH_TEST);
+    glActiveTexture(GL_TEXTURE0 + (integer ? PICK_UINT_UNIT : PICK_FLOAT_UNIT));
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader->Bind();
+    shader->SetUniform1i("floatTexture", PICK_FLOAT_UNIT);
+    shader->SetUniform1i("uintTexture", PICK_UINT_UNIT);
+    shader->SetUniform1i("integer_source", integer ? 1 : 0);
+    shader->SetUniform3i("voxel", voxel.x, voxel.y, voxel.z);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_POINTS, 0, 1);
+    glBindVertexArray(0);
+    shader->Unbind();
+
+    glReadPixels(0, 0, 1, 1, GL_RGBA_INTEGER, GL_UNSIGNED_INT, out);    // a single pixel: no full-frame readback
+
+    glBindFramebuffer(GL_FRAMEBUFFER, bound);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (depth_test) glEnable(GL_DEPTH_TEST);
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "tira/graphics_gl.h"
+#include "program.h"
+#include "overlay.h"
+
+#include <string>
+
+/// <summary>
+/// Values under the mouse cursor (updated whenever the cursor or the slices move)
+/// </summary>
+struct ProbeResult {
+    bool valid = false;                                 // the cursor is over a slice inside the volume
+    int view = -1;                                      // quadrant under the cursor (see ViewId)
+    glm::ivec3 voxel = glm::ivec3(0);                   // voxel index (x, y, z)
+    glm::vec3 physical = glm::vec3(0.0f);               // voxel center in physical units
+    size_t channels = 0;
+    float value[4] = { 0, 0, 0, 0 };                    // raw value(s) of the primary volume
+    bool has_label = false;
+    unsigned int label = 0;                             // id in the label volume (if one is loaded)
+    size_t overlay_count = 0;
+    unsigned int overlay[MAX_OVERLAYS][4] = {};         // raw value(s) of each overlay
+};
+
+/// <summary>
+/// Reads single voxels from textures whose host copy has been released (overlays, labels). The voxel is fetched
+/// by drawing one point into a 1x1 integer framebuffer and reading that pixel back, so the cost does not depend
+/// on the size of the volume or the window.
+/// </summary>
+class glPicker {
+    GLuint fbo = 0;
+    GLuint color = 0;                                   // 1x1 RGBA32UI render target
+    GLuint vao = 0;                                     // empty vertex array (the point position is constant)
+    glProgram* shader = nullptr;
+
+    bool Init();
+    bool Pick(GLuint texture, bool integer, glm::ivec3 voxel, unsigned int* out);
+
+public:
+    void Destroy();                                     // release the GL objects (requires a current context)
+
+    /// <summary>
+    /// Read the value(s) of a voxel from an 8-bit normalized 3D texture (returned as 0 - 255)
+    /// </summary>
+    bool PickFloat(GLuint texture, glm::ivec3 voxel, unsigned int out[4]) { return Pick(texture, false, voxel, out); }
+
+    /// <summary>
+    /// Read the value of a voxel from an unsigned integer 3D texture
+    /// </summary>
+    bool PickUint(GLuint texture, glm::ivec3 voxel, unsigned int out[4]) { return Pick(texture, true, voxel, out); }
+};
@@ -0,0 +1,188 @@
+#include "program.h"
+#include "cache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#define PROGRAM_CACHE_MAGIC 0x50564f47u                 // "GOVP": glOrthoView program
+
+/// <summary>
+/// Vendor, renderer and version of the driver: a binary is only valid for the driver that produced it
+/// </summary>
+static std::string DriverString() {
+    std::string driver;
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const GLubyte* s = glGetString(name);
+        driver += s ? (const char*)s : "?";
+        driver += "|";
+    }
+    return driver;
+}
+
+static bool BinaryCacheSupported() {
+    if (!GLEW_ARB_get_program_binary) return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+static GLuint CompileShader(GLenum type, const std::string& source) {
+    GLuint shader = glCreateShader(type);
+    const char* text = source.c_str();
+    glShaderSource(shader, 1, &text, nullptr);
+    glCompileShader(shader);
+    GLint status;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status) {
+        GLint length = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::string log(std::max(length, 1), '\0');
+        glGetShaderInfoLog(shader, (GLsizei)log.size(), nullptr, &log[0]);
+        std::cout << "ERROR: " << ((type == GL_VERTEX_SHADER) ? "vertex" : "fragment") << " shader compilation failed" << std::endl << log.c_str() << std::endl;
+    }
+    return shader;
+}
+
+/// <summary>
+/// Load a cached binary into the program. Entries hold the magic number, the binary format, the driver string and
+/// the binary itself; an entry written by another driver (or a hash collision) is rejected.
+/// </summary>
+static bool LoadBinary(GLuint program, const std::string& filename, const std::string& driver) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) return false;
+    uint32_t magic = 0, format = 0, driver_length = 0;
+    in.read((char*)&magic, sizeof(magic));
+    in.read((char*)&format, sizeof(format));
+    in.read((char*)&driver_length, sizeof(driver_length));
+    if (!in || magic != PROGRAM_CACHE_MAGIC || driver_length != driver.size()) return false;
+    std::string stored(driver_length, '\0');
+    in.read(&stored[0], driver_length);
+    if (!in || stored != driver) return false;
+    std::vector<char> binary((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (binary.empty()) return false;
+
+    glProgramBinary(program, (GLenum)format, binary.data(), (GLsizei)binary.size());
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    return status == GL_TRUE;
+}
+
+static void SaveBinary(GLuint program, const std::string& filename, const std::string& driver) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    if (length <= 0) return;
+
+    std::error_code ec;
+    std::string tmp = filename + ".tmp";                // renamed when complete, so a partial entry is never loaded
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        uint32_t header[3] = { PROGRAM_CACHE_MAGIC, (uint32_t)format, (uint32_t)driver.size() };
+        out.write((const char*)header, sizeof(header));
+        out.write(driver.data(), driver.size());
+        out.write(binary.data(), length);
+        if (!out) {
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, filename, ec);
+    if (ec) std::filesystem::remove(tmp, ec);
+}
+
+glProgram::glProgram(const std::string& vertex_source, const std::string& fragment_source) {
+    program = glCreateProgram();
+
+    bool use_cache = BinaryCacheSupported();
+    std::string driver, filename;
+    if (use_cache) {
+        driver = DriverString();
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", CacheHash(vertex_source + '\0' + fragment_source + '\0' + driver));
+        filename = (std::filesystem::path(CacheDirectory("shaders")) / name).string();
+        if (LoadBinary(program, filename, driver)) {
+            TouchCacheFile(filename);
+            cached = true;
+            return;
+        }
+        glDeleteProgram(program);                       // a rejected binary can leave the program in an unusable state
+        program = glCreateProgram();
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, vertex_source);
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fragment_source);
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    glDetachShader(program, vs);
+    glDetachShader(program, fs);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::string log(std::max(length, 1), '\0');
+        glGetProgramInfoLog(program, (GLsizei)log.size(), nullptr, &log[0]);
+        std::cout << "ERROR: shader program link failed" << std::endl << log.c_str() << std::endl;
+        return;
+    }
+    if (use_cache) SaveBinary(program, filename, driver);
+}
+
+glProgram::~glProgram() {
+    if (program) glDeleteProgram(program);
+}
+
+void glProgram::Bind() {
+    glUseProgram(program);
+}
+
+void glProgram::Unbind() {
+    glUseProgram(0);
+}
+
+GLint glProgram::Location(const std::string& name) {
+    auto it = locations.find(name);
+    if (it != locations.end()) return it->second;
+    GLint location = glGetUniformLocation(program, name.c_str());
+    locations[name] = location;
+    return location;
+}
+
+void glProgram::SetUniform1i(const std::string& name, int v) {
+    glUniform1i(Location(name), v);
+}
+
+void glProgram::SetUniform1f(const std::string& name, float v) {
+    glUniform1f(Location(name), v);
+}
+
+void glProgram::SetUniform3i(const std::string& name, int x, int y, int z) {
+    glUniform3i(Location(name), x, y, z);
+}
+
+void glProgram::SetUniform3f(const std::string& name, float x, float y, float z) {
+    glUniform3f(Location(name), x, y, z);
+}
+
+void glProgram::SetUniform4f(const std::string& name, float x, float y, float z, float w) {
+    glUniform4f(Location(name), x, y, z, w);
+}
+
+void glProgram::SetUniformMat4f(const std::string& name, glm::mat4 m) {
+    glUniformMatrix4fv(Location(name), 1, GL_FALSE, glm::value_ptr(m));
+}
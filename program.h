@@ -0,0 +1,40 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <unordered_map>
+
+/// <summary>
+/// GLSL program linked from a vertex and a fragment shader, with the uniform setters of tira::glShader. Linked
+/// programs are kept in an on-disk cache of program binaries (ARB_get_program_binary) keyed by a hash of the sources
+/// and of the driver (vendor, renderer and version strings), so shaders are only compiled the first time they are
+/// used with a driver. A cached binary that is missing, stale or rejected by the driver falls back to compiling the
+/// sources (and replaces the cache entry).
+/// </summary>
+class glProgram {
+    GLuint program = 0;
+    std::unordered_map<std::string, GLint> locations;   // uniform locations, looked up once per name
+    bool cached = false;                                // the program was loaded from the binary cache
+
+    GLint Location(const std::string& name);
+
+public:
+    glProgram(const std::string& vertex_source, const std::string& fragment_source);
+    ~glProgram();
+    glProgram(const glProgram&) = delete;
+    glProgram& operator=(const glProgram&) = delete;
+
+    void Bind();
+    void Unbind();
+    GLuint ID() const { return program; }
+    bool Cached() const { return cached; }
+
+    void SetUniform1i(const std::string& name, int v);
+    void SetUniform1f(const std::string& name, float v);
+    void SetUniform3i(const std::string& name, int x, int y, int z);
+    void SetUniform3f(const std::string& name, float x, float y, float z);
+    void SetUniform4f(const std::string& name, float x, float y, float z, float w);
+    void SetUniformMat4f(const std::string& name, glm::mat4 m);
+};
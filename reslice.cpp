@@ -0,0 +1,142 @@
+#include "reslice.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RESLICE_SSE
+#endif
+
+bool SampleTrilinear(const VoxelGrid& g, glm::vec3 p, float* out) {
+    if (p.x < 0 || p.y < 0 || p.z < 0 || p.x > g.X - 1 || p.y > g.Y - 1 || p.z > g.Z - 1) {
+        for (size_t c = 0; c < g.C; c++) out[c] = 0.0f;
+        return false;
+    }
+    size_t x0 = (size_t)p.x, y0 = (size_t)p.y, z0 = (size_t)p.z;
+    float fx = p.x - x0, fy = p.y - y0, fz = p.z - z0;
+    size_t dx = (x0 + 1 < g.X) ? g.C : 0;               // offsets to the neighboring voxels (clamped at the upper boundary)
+    size_t dy = (y0 + 1 < g.Y) ? g.X * g.C : 0;
+    size_t dz = (z0 + 1 < g.Z) ? g.X * g.Y * g.C : 0;
+    const unsigned char* v = g.voxel(x0, y0, z0);
+
+    for (size_t c = 0; c < g.C; c++) {
+        float c00 = v[c] + fx * (v[c + dx] - v[c]);
+        float c10 = v[c + dy] + fx * (v[c + dy + dx] - v[c + dy]);
+        float c01 = v[c + dz] + fx * (v[c + dz + dx] - v[c + dz]);
+        float c11 = v[c + dz + dy] + fx * (v[c + dz + dy + dx] - v[c + dz + dy]);
+        float c0 = c00 + fy * (c10 - c00);
+        float c1 = c01 + fy * (c11 - c01);
+        out[c] = c0 + fz * (c1 - c0);
+    }
+    return true;
+}
+
+/// <summary>
+/// Resample one output row starting at voxel position p and advancing by u for each sample
+/// </summary>
+static void ResliceRow(const VoxelGrid& g, glm::vec3 p, glm::vec3 u, int width, unsigned char* out) {
+    int x = 0;
+
+#ifdef RESLICE_SSE
+    const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    __m128 px = _mm_add_ps(_mm_set1_ps(p.x), _mm_mul_ps(lane, _mm_set1_ps(u.x)));
+    __m128 py = _mm_add_ps(_mm_set1_ps(p.y), _mm_mul_ps(lane, _mm_set1_ps(u.y)));
+    __m128 pz = _mm_add_ps(_mm_set1_ps(p.z), _mm_mul_ps(lane, _mm_set1_ps(u.z)));
+    const __m128 sx = _mm_set1_ps(4.0f * u.x);
+    const __m128 sy = _mm_set1_ps(4.0f * u.y);
+    const __m128 sz = _mm_set1_ps(4.0f * u.z);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 max_x = _mm_set1_ps((float)(g.X - 1));
+    const __m128 max_y = _mm_set1_ps((float)(g.Y - 1));
+    const __m128 max_z = _mm_set1_ps((float)(g.Z - 1));
+
+    alignas(16) int ix[4], iy[4], iz[4];
+    alignas(16) float corner[8][4];
+    const unsigned char* base[4];
+    size_t dx[4], dy[4], dz[4];
+
+    for (; x + 4 <= width; x += 4) {
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(px, zero), _mm_cmple_ps(px, max_x)),
+                        _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(py, zero), _mm_cmple_ps(py, max_y)),
+                                   _mm_and_ps(_mm_cmpge_ps(pz, zero), _mm_cmple_ps(pz, max_z))));
+        int mask = _mm_movemask_ps(inside);
+        if (mask == 0) {                                // all four samples are outside of the volume
+            std::fill(out + (size_t)x * g.C, out + (size_t)(x + 4) * g.C, (unsigned char)0);
+        }
+        else {
+            __m128 cx = _mm_max_ps(px, zero), cy = _mm_max_ps(py, zero), cz = _mm_max_ps(pz, zero);
+            __m128i i_x = _mm_cvttps_epi32(cx), i_y = _mm_cvttps_epi32(cy), i_z = _mm_cvttps_epi32(cz);
+            __m128 fx = _mm_sub_ps(cx, _mm_cvtepi32_ps(i_x));
+            __m128 fy = _mm_sub_ps(cy, _mm_cvtepi32_ps(i_y));
+            __m128 fz = _mm_sub_ps(cz, _mm_cvtepi32_ps(i_z));
+            _mm_store_si128((__m128i*)ix, i_x);
+            _mm_store_si128((__m128i*)iy, i_y);
+            _mm_store_si128((__m128i*)iz, i_z);
+
+            for (int k = 0; k < 4; k++) {
+                if (!(mask & (1 << k))) { base[k] = nullptr; continue; }
+                base[k] = g.voxel(ix[k], iy[k], iz[k]);
+                dx[k] = ((size_t)ix[k] + 1 < g.X) ? g.C : 0;
+                dy[k] = ((size_t)iy[k] + 1 < g.Y) ? g.X * g.C : 0;
+                dz[k] = ((size_t)iz[k] + 1 < g.Z) ? g.X * g.Y * g.C : 0;
+            }
+
+            for (size_t c = 0; c < g.C; c++) {
+                for (int k = 0; k < 4; k++) {           // gather the eight corners of each sample
+                    const unsigned char* v = base[k];
+                    if (!v) {
+                        for (int n = 0; n < 8; n++) corner[n][k] = 0.0f;
+                        continue;
+                    }
+                    v += c;
+                    corner[0][k] = v[0];
+                    corner[1][k] = v[dx[k]];
+                    corner[2][k] = v[dy[k]];
+                    corner[3][k] = v[dy[k] + dx[k]];
+                    corner[4][k] = v[dz[k]];
+                    corner[5][k] = v[dz[k] + dx[k]];
+                    corner[6][k] = v[dz[k] + dy[k]];
+                    corner[7][k] = v[dz[k] + dy[k] + dx[k]];
+                }
+                __m128 c000 = _mm_load_ps(corner[0]), c100 = _mm_load_ps(corner[1]);
+                __m128 c010 = _mm_load_ps(corner[2]), c110 = _mm_load_ps(corner[3]);
+                __m128 c001 = _mm_load_ps(corner[4]), c101 = _mm_load_ps(corner[5]);
+                __m128 c011 = _mm_load_ps(corner[6]), c111 = _mm_load_ps(corner[7]);
+                __m128 c00 = _mm_add_ps(c000, _mm_mul_ps(fx, _mm_sub_ps(c100, c000)));
+                __m128 c10 = _mm_add_ps(c010, _mm_mul_ps(fx, _mm_sub_ps(c110, c010)));
+                __m128 c01 = _mm_add_ps(c001, _mm_mul_ps(fx, _mm_sub_ps(c101, c001)));
+                __m128 c11 = _mm_add_ps(c011, _mm_mul_ps(fx, _mm_sub_ps(c111, c011)));
+                __m128 c0 = _mm_add_ps(c00, _mm_mul_ps(fy, _mm_sub_ps(c10, c00)));
+                __m128 c1 = _mm_add_ps(c01, _mm_mul_ps(fy, _mm_sub_ps(c11, c01)));
+                __m128 r = _mm_add_ps(_mm_add_ps(c0, _mm_mul_ps(fz, _mm_sub_ps(c1, c0))), _mm_set1_ps(0.5f));
+                __m128i ri = _mm_cvttps_epi32(r);
+                alignas(16) int result[4];
+                _mm_store_si128((__m128i*)result, ri);
+                for (int k = 0; k < 4; k++)
+                    out[(size_t)(x + k) * g.C + c] = (unsigned char)std::min(255, result[k]);
+            }
+        }
+        px = _mm_add_ps(px, sx);
+        py = _mm_add_ps(py, sy);
+        pz = _mm_add_ps(pz, sz);
+    }
+#endif
+
+    std::vector<float> sample(g.C);
+    glm::vec3 q = p + (float)x * u;
+    for (; x < width; x++, q += u) {
+        SampleTrilinear(g, q, sample.data());
+        for (size_t c = 0; c < g.C; c++)
+            out[(size_t)x * g.C + c] = (unsigned char)std::min(255.0f, sample[c] + 0.5f);
+    }
+}
+
+void ReslicePlane(const VoxelGrid& grid, glm::vec3 origin, glm::vec3 u, glm::vec3 v, int width, int height, unsigned char* out) {
+    parallel_for((size_t)height, [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++)
+            ResliceRow(grid, origin + (float)row * v, u, width, out + row * width * grid.C);
+    }, 16);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+/// <summary>
+/// Read-only view of a volume stored in x-fastest order with interleaved channels (the layout of tira::volume)
+/// </summary>
+struct VoxelGrid {
+    const unsigned char* data = nullptr;
+    size_t X = 0, Y = 0, Z = 0, C = 1;
+
+    const unsigned char* voxel(size_t x, size_t y, size_t z) const { return data + ((z * Y + y) * X + x) * C; }
+};
+
+/// <summary>
+/// Trilinearly interpolate all channels of the grid at a (continuous) voxel position. Positions outside of
+/// [0, dim - 1] along any axis return zero. Returns false if the position is outside of the grid.
+/// </summary>
+bool SampleTrilinear(const VoxelGrid& grid, glm::vec3 p, float* out);
+
+/// <summary>
+/// Resample an arbitrary plane through the grid using trilinear interpolation. Rows are distributed across
+/// threads; within a row the sample position is advanced incrementally by u (four samples at a time with SSE).
+/// </summary>
+/// <param name="grid">Source volume</param>
+/// <param name="origin">Voxel position of output pixel (0, 0)</param>
+/// <param name="u">Step (in voxels) between adjacent output columns</param>
+/// <param name="v">Step (in voxels) between adjacent output rows</param>
+/// <param name="width">Number of output columns</param>
+/// <param name="height">Number of output rows</param>
+/// <param name="out">Output image (width * height * grid.C bytes, top row first)</param>
+void ReslicePlane(const VoxelGrid& grid, glm::vec3 origin, glm::vec3 u, glm::vec3 v, int width, int height, unsigned char* out);
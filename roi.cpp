@@ -0,0 +1,209 @@
+#include "roi.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ROI_SSE
+#endif
+
+#define ROI_BRICK 32                                    // edge length (in voxels) of the bricks the ROI is split into
+
+/// <summary>
+/// Running sums for one channel of a set of voxels
+/// </summary>
+struct RoiAccumulator {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t sumsq = 0;
+    int min = 255;
+    int max = 0;
+
+    void add(const RoiAccumulator& a) {
+        count += a.count;
+        sum += a.sum;
+        sumsq += a.sumsq;
+        min = std::min(min, a.min);
+        max = std::max(max, a.max);
+    }
+};
+
+/// <summary>
+/// Accumulate n values spaced stride bytes apart
+/// </summary>
+static void ReduceRun(const unsigned char* p, size_t n, size_t stride, RoiAccumulator& a) {
+    if (n == 0) return;
+    size_t i = 0;
+    a.count += n;
+
+#ifdef ROI_SSE
+    if (stride == 1 && n >= 16) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i sum = _mm_setzero_si128();              // two 64-bit partial sums
+        __m128i vmin = _mm_set1_epi8((char)0xff);
+        __m128i vmax = _mm_setzero_si128();
+        uint64_t sumsq = 0;
+
+        while (i + 16 <= n) {
+            __m128i sq = _mm_setzero_si128();           // 32-bit partial sums of squares (flushed before they can overflow)
+            size_t block_end = std::min(n - n % 16, i + 16 * 8192);
+            for (; i < block_end; i += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+                sum = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+                vmin = _mm_min_epu8(vmin, v);
+                vmax = _mm_max_epu8(vmax, v);
+                __m128i lo = _mm_unpacklo_epi8(v, zero);
+                __m128i hi = _mm_unpackhi_epi8(v, zero);
+                sq = _mm_add_epi32(sq, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+            }
+            alignas(16) uint32_t sq32[4];
+            _mm_store_si128((__m128i*)sq32, sq);
+            sumsq += (uint64_t)sq32[0] + sq32[1] + sq32[2] + sq32[3];
+        }
+
+        alignas(16) uint64_t sum64[2];
+        alignas(16) unsigned char mn[16], mx[16];
+        _mm_store_si128((__m128i*)sum64, sum);
+        _mm_store_si128((__m128i*)mn, vmin);
+        _mm_store_si128((__m128i*)mx, vmax);
+        a.sum += sum64[0] + sum64[1];
+        a.sumsq += sumsq;
+        for (int k = 0; k < 16; k++) {
+            a.min = std::min(a.min, (int)mn[k]);
+            a.max = std::max(a.max, (int)mx[k]);
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        int v = p[i * stride];
+        a.sum += v;
+        a.sumsq += (uint64_t)(v * v);
+        a.min = std::min(a.min, v);
+        a.max = std::max(a.max, v);
+    }
+}
+
+/// <summary>
+/// Accumulate n copies of the value v
+/// </summary>
+static void AddConstant(int v, size_t n, RoiAccumulator& a) {
+    if (n == 0) return;
+    a.count += n;
+    a.sum += (uint64_t)v * n;
+    a.sumsq += (uint64_t)v * v * n;
+    a.min = std::min(a.min, v);
+    a.max = std::max(a.max, v);
+}
+
+RoiStats ComputeRoiStats(const VoxelGrid& g, const Roi& roi, size_t channel, const MinMaxGrid* ranges) {
+    RoiStats stats;
+    if (!g.data || channel >= g.C) return stats;
+    if (ranges && !ranges->Matches(g)) ranges = nullptr;
+
+    // bounding box of the ROI clamped to the grid
+    glm::ivec3 lo, hi;
+    if (roi.shape == ROI_BOX) {
+        lo = glm::min(roi.lo, roi.hi);
+        hi = glm::max(roi.lo, roi.hi);
+    }
+    else {
+        if (roi.radius.x <= 0 || roi.radius.y <= 0 || roi.radius.z <= 0) return stats;
+        lo = glm::ivec3((int)std::ceil(roi.center.x - roi.radius.x), (int)std::ceil(roi.center.y - roi.radius.y), (int)std::ceil(roi.center.z - roi.radius.z));
+        hi = glm::ivec3((int)std::floor(roi.center.x + roi.radius.x), (int)std::floor(roi.center.y + roi.radius.y), (int)std::floor(roi.center.z + roi.radius.z));
+    }
+    lo = glm::max(lo, glm::ivec3(0));
+    hi = glm::min(hi, glm::ivec3((int)g.X - 1, (int)g.Y - 1, (int)g.Z - 1));
+    if (lo.x > hi.x || lo.y > hi.y || lo.z > hi.z) return stats;
+
+    // bricks are aligned to the volume so that they coincide with the bricks of the range grid
+    int B = ranges ? (int)ranges->BrickSize() : ROI_BRICK;
+    glm::ivec3 first(lo.x / B, lo.y / B, lo.z / B);
+    glm::ivec3 bricks(hi.x / B - first.x + 1, hi.y / B - first.y + 1, hi.z / B - first.z + 1);
+    size_t nbricks = (size_t)bricks.x * bricks.y * bricks.z;
+    int depth = hi.z - lo.z + 1;
+
+    RoiAccumulator total;
+    std::vector<RoiAccumulator> slices(depth);
+    std::mutex m;
+
+    parallel_for(nbricks, [&](size_t begin, size_t end) {
+        RoiAccumulator local;
+        std::vector<RoiAccumulator> local_slices(depth);
+
+        for (size_t b = begin; b < end; b++) {
+            glm::ivec3 bi = first + glm::ivec3((int)(b % bricks.x), (int)((b / bricks.x) % bricks.y), (int)(b / ((size_t)bricks.x * bricks.y)));
+            glm::ivec3 b0 = glm::max(glm::ivec3(bi.x * B, bi.y * B, bi.z * B), lo);
+            glm::ivec3 b1 = glm::min(glm::ivec3(bi.x * B + B - 1, bi.y * B + B - 1, bi.z * B + B - 1), hi);
+
+            if (roi.shape == ROI_SPHERE) {              // skip bricks that do not intersect the sphere
+                float d = 0.0f;
+                for (int a = 0; a < 3; a++) {
+                    float c = std::clamp(roi.center[a], (float)b0[a], (float)b1[a]);
+                    float n = (c - roi.center[a]) / roi.radius[a];
+                    d += n * n;
+                }
+                if (d > 1.0f) continue;
+            }
+
+            // a brick holding a single value (ex. background) is accumulated without reading its voxels
+            int uniform = -1;
+            if (ranges) {
+                size_t r = ranges->Index(bi.x, bi.y, bi.z);
+                if (ranges->Min(r, channel) == ranges->Max(r, channel)) uniform = ranges->Min(r, channel);
+            }
+
+            for (int z = b0.z; z <= b1.z; z++) {
+                RoiAccumulator& slice = local_slices[z - lo.z];
+                for (int y = b0.y; y <= b1.y; y++) {
+                    int x0 = b0.x, x1 = b1.x;
+                    if (roi.shape == ROI_SPHERE) {      // the intersection of a row with the sphere is a single run
+                        float dy = (y - roi.center.y) / roi.radius.y;
+                        float dz = (z - roi.center.z) / roi.radius.z;
+                        float r2 = 1.0f - dy * dy - dz * dz;
+                        if (r2 < 0.0f) continue;
+                        float half = roi.radius.x * std::sqrt(r2);
+                        x0 = std::max(x0, (int)std::ceil(roi.center.x - half));
+                        x1 = std::min(x1, (int)std::floor(roi.center.x + half));
+                        if (x0 > x1) continue;
+                    }
+                    if (uniform >= 0) AddConstant(uniform, (size_t)(x1 - x0 + 1), slice);
+                    else ReduceRun(g.voxel(x0, y, z) + channel, (size_t)(x1 - x0 + 1), g.C, slice);
+                }
+            }
+        }
+
+        for (const RoiAccumulator& s : local_slices) local.add(s);
+        std::lock_guard<std::mutex> lock(m);
+        total.add(local);
+        for (int z = 0; z < depth; z++) slices[z].add(local_slices[z]);
+    });
+
+    stats.count = total.count;
+    if (total.count == 0) return stats;
+    stats.mean = (double)total.sum / total.count;
+    stats.stddev = std::sqrt(std::max(0.0, (double)total.sumsq / total.count - stats.mean * stats.mean));
+    stats.min = total.min;
+    stats.max = total.max;
+    stats.z0 = lo.z;
+    stats.slice_mean.resize(depth);
+    for (int z = 0; z < depth; z++)
+        stats.slice_mean[z] = slices[z].count ? (float)((double)slices[z].sum / slices[z].count) : 0.0f;
+    return stats;
+}
+
+std::vector<float> SampleProfile(const VoxelGrid& grid, glm::vec3 a, glm::vec3 b, size_t channel, size_t samples) {
+    std::vector<float> profile(samples);
+    if (samples == 0 || channel >= grid.C) return profile;
+    std::vector<float> value(grid.C);
+    glm::vec3 step = (samples > 1) ? (b - a) / (float)(samples - 1) : glm::vec3(0.0f);
+    glm::vec3 p = a;
+    for (size_t i = 0; i < samples; i++, p += step) {
+        SampleTrilinear(grid, p, value.data());
+        profile[i] = value[channel];
+    }
+    return profile;
+}
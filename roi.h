@@ -0,0 +1,46 @@
+#pragma once
+
+#include "minmax.h"
+
+#include <cstdint>
+#include <vector>
+
+enum RoiShape { ROI_BOX = 0, ROI_SPHERE };
+
+/// <summary>
+/// Region of interest in voxel coordinates. Boxes are given by their (inclusive) corner voxels, spheres by a
+/// center and a per-axis radius in voxels (an ellipsoid in voxel space when the spacing is anisotropic).
+/// </summary>
+struct Roi {
+    int shape = ROI_BOX;
+    glm::ivec3 lo = glm::ivec3(0);                      // box corners
+    glm::ivec3 hi = glm::ivec3(0);
+    glm::vec3 center = glm::vec3(0.0f);                 // sphere center
+    glm::vec3 radius = glm::vec3(0.0f);                 // sphere radius along each axis
+};
+
+/// <summary>
+/// Statistics of one channel of the voxels inside an ROI
+/// </summary>
+struct RoiStats {
+    uint64_t count = 0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    int min = 0;
+    int max = 0;
+    int z0 = 0;                                         // first slice touched by the ROI
+    std::vector<float> slice_mean;                      // mean of the ROI in each slice from z0 (for plotting)
+};
+
+/// <summary>
+/// Compute ROI statistics. The bounding box of the ROI is split into bricks that are processed in parallel; bricks
+/// outside of a spherical ROI are skipped, and each row inside the ROI is reduced as one contiguous run (with SSE2
+/// for single-channel volumes), so no per-voxel inside/outside test is performed.
+/// </summary>
+/// <param name="ranges">Optional brick ranges of grid: bricks holding a single value are not read</param>
+RoiStats ComputeRoiStats(const VoxelGrid& grid, const Roi& roi, size_t channel, const MinMaxGrid* ranges = nullptr);
+
+/// <summary>
+/// Sample one channel along a line segment (in voxel coordinates) with trilinear interpolation
+/// </summary>
+std::vector<float> SampleProfile(const VoxelGrid& grid, glm::vec3 a, glm::vec3 b, size_t channel, size_t samples);
@@ -0,0 +1,147 @@
+#include "segment.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <thread>
+
+size_t ThresholdPreview::Channel(size_t channels) const {
+    channels = std::min<size_t>(channels, 4);
+    if (channels == 0 || channel < 0) return 0;
+    return std::min((size_t)channel, channels - 1);
+}
+
+void ThresholdPreview::Bind(glProgram* shader, size_t channels) const {
+    shader->SetUniform1i("threshold_enable", enable ? 1 : 0);
+    shader->SetUniform1i("threshold_channel", (int)Channel(channels));
+    shader->SetUniform1f("threshold_lo", (lo - 0.5f) / 255.0f);     // compare against the normalized texture value
+    shader->SetUniform1f("threshold_hi", (hi + 0.5f) / 255.0f);
+    shader->SetUniform1f("threshold_opacity", opacity);
+}
+
+/// <summary>
+/// Union-find root with path halving
+/// </summary>
+static uint32_t Find(std::vector<uint32_t>& parent, uint32_t a) {
+    while (parent[a] != a) {
+        parent[a] = parent[parent[a]];
+        a = parent[a];
+    }
+    return a;
+}
+
+/// <summary>
+/// Merge two sets, keeping the smaller id as the root so that roots are reached in scan order
+/// </summary>
+static uint32_t Union(std::vector<uint32_t>& parent, uint32_t a, uint32_t b) {
+    a = Find(parent, a);
+    b = Find(parent, b);
+    if (a < b) std::swap(a, b);
+    parent[a] = b;
+    return b;
+}
+
+/// <summary>
+/// Provisional labels of one slab: ids are local to the slab (1 - n) until the tables are merged
+/// </summary>
+struct SlabLabels {
+    size_t z0 = 0, z1 = 0;                              // slices [z0, z1)
+    std::vector<uint32_t> parent;                       // local equivalence table (entry 0 is the background)
+    std::vector<uint64_t> count;                        // voxels given each provisional label
+    uint32_t offset = 0;                                // first entry of this slab in the global table
+};
+
+ComponentStats LabelComponents(const VoxelGrid& g, size_t channel, int lo, int hi, std::vector<uint32_t>& labels) {
+    ComponentStats stats;
+    size_t N = g.X * g.Y * g.Z;
+    labels.assign(N, 0);
+    if (!g.data || N == 0 || channel >= g.C) return stats;
+
+    size_t slice = g.X * g.Y;
+    size_t nslabs = std::min<size_t>(g.Z, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<SlabLabels> slabs(nslabs);
+    for (size_t s = 0; s < nslabs; s++) {
+        slabs[s].z0 = g.Z * s / nslabs;
+        slabs[s].z1 = g.Z * (s + 1) / nslabs;
+    }
+
+    // pass 1: label each slab independently, merging equivalent labels through the -x, -y and -z neighbors
+    parallel_for(nslabs, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; s++) {
+            SlabLabels& slab = slabs[s];
+            slab.parent.assign(1, 0);
+            slab.count.assign(1, 0);
+            for (size_t z = slab.z0; z < slab.z1; z++) {
+                for (size_t y = 0; y < g.Y; y++) {
+                    const unsigned char* src = g.voxel(0, y, z) + channel;
+                    uint32_t* row = &labels[z * slice + y * g.X];
+                    for (size_t x = 0; x < g.X; x++) {
+                        int v = src[x * g.C];
+                        if (v < lo || v > hi) continue;
+                        uint32_t l = 0;
+                        if (x > 0 && row[x - 1]) l = row[x - 1];
+                        if (y > 0 && row[x - g.X]) l = l ? Union(slab.parent, l, row[x - g.X]) : row[x - g.X];
+                        if (z > slab.z0 && row[x - slice]) l = l ? Union(slab.parent, l, row[x - slice]) : row[x - slice];
+                        if (l == 0) {                   // no labeled neighbor: start a new provisional label
+                            l = (uint32_t)slab.parent.size();
+                            slab.parent.push_back(l);
+                            slab.count.push_back(0);
+                        }
+                        row[x] = l;
+                        slab.count[l]++;
+                    }
+                }
+            }
+        }
+    }, 1);
+
+    // merge: concatenate the slab tables and join labels that touch across each slab boundary
+    uint32_t total = 1;
+    for (SlabLabels& slab : slabs) {
+        slab.offset = total - 1;                        // local id l maps to global id offset + l
+        total += (uint32_t)slab.parent.size() - 1;
+    }
+    std::vector<uint32_t> parent(total);
+    std::vector<uint64_t> count(total, 0);
+    parent[0] = 0;
+    for (SlabLabels& slab : slabs) {
+        for (size_t l = 1; l < slab.parent.size(); l++) {
+            parent[slab.offset + l] = slab.offset + Find(slab.parent, (uint32_t)l);
+            count[slab.offset + l] = slab.count[l];
+        }
+        std::vector<uint32_t>().swap(slab.parent);
+        std::vector<uint64_t>().swap(slab.count);
+    }
+    for (size_t s = 1; s < nslabs; s++) {
+        const uint32_t* below = &labels[(slabs[s].z0 - 1) * slice];
+        const uint32_t* above = &labels[slabs[s].z0 * slice];
+        for (size_t i = 0; i < slice; i++) {
+            if (below[i] && above[i])
+                Union(parent, slabs[s - 1].offset + below[i], slabs[s].offset + above[i]);
+        }
+    }
+
+    // assign compact ids to the roots (in scan order) and sum the component sizes
+    std::vector<uint32_t> final_id(total, 0);
+    for (uint32_t l = 1; l < total; l++) {
+        uint32_t root = Find(parent, l);
+        if (root == l) {
+            final_id[l] = (uint32_t)++stats.count;
+            stats.sizes.push_back(0);
+        }
+        else
+            final_id[l] = final_id[root];               // roots precede the labels that point to them
+        stats.sizes[final_id[l] - 1] += count[l];
+        stats.foreground += count[l];
+    }
+
+    // pass 2: replace the provisional labels with the final ids
+    parallel_for(nslabs, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; s++) {
+            uint32_t* p = &labels[slabs[s].z0 * slice];
+            uint32_t* p_end = &labels[slabs[s].z1 * slice];
+            for (; p < p_end; p++)
+                if (*p) *p = final_id[slabs[s].offset + *p];
+        }
+    }, 1);
+    return stats;
+}
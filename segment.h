@@ -0,0 +1,49 @@
+#pragma once
+
+#include "tira/graphics_gl.h"
+#include "program.h"
+#include "reslice.h"
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Binary threshold preview drawn over the slices. The test is done per fragment in the slicer shader, so moving
+/// the thresholds only changes uniforms.
+/// </summary>
+struct ThresholdPreview {
+    bool enable = false;
+    int lo = 128;                                       // voxels with lo <= value <= hi are foreground
+    int hi = 255;
+    int channel = 0;                                    // channel of the primary volume that is tested
+    float opacity = 0.5f;
+
+    /// <summary>
+    /// Channel that is tested in a volume with the given number of channels: the selection clamped to [0, C - 1] (and to
+    /// the 4 channels the slicer shader samples), so the preview and the labeling always agree
+    /// </summary>
+    size_t Channel(size_t channels) const;
+
+    /// <summary>
+    /// Set the threshold uniforms of the slicer shader
+    /// </summary>
+    /// <param name="channels">Number of channels of the primary volume</param>
+    void Bind(glProgram* shader, size_t channels) const;
+};
+
+/// <summary>
+/// Result of a connected-components labeling
+/// </summary>
+struct ComponentStats {
+    size_t count = 0;                                   // number of components (labels are 1 - count)
+    uint64_t foreground = 0;                            // number of foreground voxels
+    std::vector<uint64_t> sizes;                        // voxel count of each component (sizes[id - 1])
+};
+
+/// <summary>
+/// Label the 6-connected components of the voxels with lo <= value <= hi. The volume is split into slabs of
+/// slices that are labeled in parallel (two-pass union-find with a local equivalence table per slab); the tables
+/// are then merged across the slab boundaries and the final, compact ids are written in a second parallel pass.
+/// </summary>
+/// <param name="labels">Receives one label per voxel (x-fastest, 0 = background)</param>
+ComponentStats LabelComponents(const VoxelGrid& grid, size_t channel, int lo, int hi, std::vector<uint32_t>& labels);
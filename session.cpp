@@ -0,0 +1,84 @@
+#include "session.h"
+#include "metadata.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static void WriteVec3(std::ofstream& out, const char* key, glm::vec3 v) {
+    out << "  \"" << key << "\": [" << v.x << ", " << v.y << ", " << v.z << "],\n";
+}
+
+bool SaveSession(std::string filename, const Session& session) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cout << "ERROR: unable to write " << filename << std::endl;
+        return false;
+    }
+    out << "{\n";
+    out << "  \"volume\": \"" << JsonEscape(session.volume) << "\",\n";
+    out << "  \"downsample\": " << session.downsample << ",\n";
+    WriteVec3(out, "volume_size", session.volume_size);
+    WriteVec3(out, "volume_slice", session.volume_slice);
+    WriteVec3(out, "camera_position", session.camera_position);
+    WriteVec3(out, "camera_lookat", session.camera_lookat);
+    WriteVec3(out, "camera_up", session.camera_up);
+    out << "  \"overlays\": " << session.overlays.size() << ",\n";
+    for (size_t i = 0; i < session.overlays.size(); i++) {          // keys are flat (overlay0_path, ...) to keep parsing trivial
+        const OverlaySession& o = session.overlays[i];
+        std::string prefix = "  \"overlay" + std::to_string(i) + "_";
+        out << prefix << "path\": \"" << JsonEscape(o.path) << "\",\n";
+        out << prefix << "colormap\": " << o.colormap << ",\n";
+        out << prefix << "blend\": " << o.blend << ",\n";
+        out << prefix << "opacity\": " << o.opacity << ",\n";
+        out << prefix << "visible\": " << (o.visible ? "true" : "false") << ",\n";
+    }
+    out << "  \"labels\": \"" << JsonEscape(session.labels) << "\",\n";
+    out << "  \"labels_visible\": " << (session.labels_visible ? "true" : "false") << ",\n";
+    out << "  \"labels_outline\": " << (session.labels_outline ? "true" : "false") << ",\n";
+    out << "  \"labels_opacity\": " << session.labels_opacity << "\n";
+    out << "}" << std::endl;
+    return (bool)out;
+}
+
+bool LoadSession(std::string filename, Session& session) {
+    std::ifstream in(filename);
+    if (!in) return false;
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string json = buffer.str();
+
+    Session result;
+    if (!JsonString(json, "volume", result.volume)) {
+        std::cout << "WARNING: " << filename << " is not a session file" << std::endl;
+        return false;
+    }
+    float value;
+    if (JsonNumber(json, "downsample", value)) result.downsample = (int)value;
+    JsonNumbers(json, "volume_size", &result.volume_size[0], 3);
+    JsonNumbers(json, "volume_slice", &result.volume_slice[0], 3);
+    JsonNumbers(json, "camera_position", &result.camera_position[0], 3);
+    JsonNumbers(json, "camera_lookat", &result.camera_lookat[0], 3);
+    JsonNumbers(json, "camera_up", &result.camera_up[0], 3);
+
+    float count = 0.0f;
+    JsonNumber(json, "overlays", count);
+    for (int i = 0; i < (int)count; i++) {
+        OverlaySession o;
+        std::string prefix = "overlay" + std::to_string(i) + "_";
+        if (!JsonString(json, prefix + "path", o.path)) continue;
+        if (JsonNumber(json, prefix + "colormap", value)) o.colormap = (int)value;
+        if (JsonNumber(json, prefix + "blend", value)) o.blend = (int)value;
+        JsonNumber(json, prefix + "opacity", o.opacity);
+        if (JsonNumber(json, prefix + "visible", value)) o.visible = (value != 0.0f);
+        result.overlays.push_back(o);
+    }
+
+    JsonString(json, "labels", result.labels);
+    if (JsonNumber(json, "labels_visible", value)) result.labels_visible = (value != 0.0f);
+    if (JsonNumber(json, "labels_outline", value)) result.labels_outline = (value != 0.0f);
+    JsonNumber(json, "labels_opacity", result.labels_opacity);
+
+    session = result;
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#define SESSION_FILE "glOrthoView_session.json"         // written to the working directory (next to imgui.ini)
+
+/// <summary>
+/// File and display settings of an overlay, enough to load it again
+/// </summary>
+struct OverlaySession {
+    std::string path;
+    int colormap = 0;
+    int blend = 0;
+    float opacity = 1.0f;
+    bool visible = true;
+};
+
+/// <summary>
+/// State of the viewer that is restored at the next launch: the files that were open, the slices and the camera.
+/// Only paths and view settings are stored, so sessions are small and are written on every exit.
+/// </summary>
+struct Session {
+    std::string volume;                                 // empty if the generated volume was displayed
+    int downsample = 1;                                 // quick look factor the volume was displayed at
+    glm::vec3 volume_size = glm::vec3(1.0f);            // gui_VolumeSize
+    glm::vec3 volume_slice = glm::vec3(0.5f);           // gui_VolumeSlice
+    glm::vec3 camera_position = glm::vec3(2.0f);
+    glm::vec3 camera_lookat = glm::vec3(0.0f);
+    glm::vec3 camera_up = glm::vec3(0.0f, 1.0f, 0.0f);
+    std::vector<OverlaySession> overlays;
+    std::string labels;                                 // empty if no label file was loaded
+    bool labels_visible = true;
+    bool labels_outline = false;
+    float labels_opacity = 0.5f;
+};
+
+/// <summary>
+/// Write a session as a flat JSON file
+/// </summary>
+bool SaveSession(std::string filename, const Session& session);
+
+/// <summary>
+/// Read a session written by SaveSession. Missing keys keep their default values.
+/// </summary>
+/// <returns>false if the file does not exist or does not describe a session</returns>
+bool LoadSession(std::string filename, Session& session);
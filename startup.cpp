@@ -0,0 +1,37 @@
+#include "startup.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+void StartupTrace::Mark(const std::string& phase) {
+    auto now = std::chrono::steady_clock::now();
+    if (enabled) {
+        double total = std::chrono::duration<double, std::milli>(now - start).count();
+        double step = std::chrono::duration<double, std::milli>(now - last).count();
+        std::ostringstream line;                        // formatted apart so that std::cout keeps its own settings
+        line << std::fixed << std::setprecision(1) << "[startup] " << std::setw(8) << total << " ms  (+" << std::setw(7) << step << " ms)  " << phase;
+        std::cout << line.str() << std::endl;
+    }
+    last = now;
+}
+
+void StartupTrace::Timing(const std::string& operation, std::chrono::steady_clock::time_point since) const {
+    if (!enabled) return;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    std::cout << "[timing] " << operation << " in " << ms << " ms" << std::endl;
+}
+
+size_t PrefetchFile(std::string filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) return 0;
+    std::vector<char> buffer((size_t)4 << 20);
+    size_t total = 0;
+    while (in) {
+        in.read(buffer.data(), buffer.size());
+        total += (size_t)in.gcount();
+    }
+    return total;
+}
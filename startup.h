@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+/// <summary>
+/// Timestamps of the phases of startup (window, GUI, shaders, volume, first frame), printed with --trace-startup.
+/// Times are measured from the construction of the trace, which is a global initialized before main. The same switch
+/// enables the timings of expensive operations (brick ranges, demo volume, downsampling, connected components).
+/// </summary>
+class StartupTrace {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last = start;
+
+public:
+    bool enabled = false;
+
+    /// <summary>
+    /// Record the end of a phase: prints the time since startup and the duration of the phase
+    /// </summary>
+    void Mark(const std::string& phase);
+
+    /// <summary>
+    /// Print the duration of an operation that started at the given time (only when tracing is enabled)
+    /// </summary>
+    void Timing(const std::string& operation, std::chrono::steady_clock::time_point since) const;
+};
+
+extern StartupTrace trace;                              // defined in glOrthoView.cpp
+
+/// <summary>
+/// Read a file sequentially and discard the data, so that a later load (on the GL thread) is served from the file
+/// cache of the operating system. Used to overlap volume I/O with the rest of startup.
+/// </summary>
+/// <returns>number of bytes read</returns>
+size_t PrefetchFile(std::string filename);
@@ -0,0 +1,79 @@
+#include "sweep.h"
+#include "capture.h"
+#include "framebuffer.h"
+#include "imagewriter.h"
+#include "parallel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+
+static std::string FrameName(const std::string& prefix, int i, const char* extension) {
+    char number[16];
+    snprintf(number, sizeof(number), "_%05d.", i);
+    return prefix + number + extension;
+}
+
+bool ExportSweep(const SweepSettings& settings, std::function<void(int i, float t)> apply, std::function<void(int width, int height)> render) {
+    int width = settings.width;
+    int height = settings.height;
+    if (settings.format == SWEEP_Y4M) {                 // 4:2:0 chroma subsampling requires even dimensions
+        width &= ~1;
+        height &= ~1;
+    }
+    if (width <= 0 || height <= 0 || settings.frames <= 0) return false;
+
+    glFramebuffer target;
+    if (!target.Resize(width, height)) return false;
+
+    Y4MWriter y4m;
+    if (settings.format == SWEEP_Y4M && !y4m.Open(settings.prefix + ".y4m", width, height, settings.fps))
+        return false;
+
+    WorkerPool encoders;
+    const size_t max_in_flight = 2 * encoders.size();   // bounds the number of frames held in memory
+    auto start = std::chrono::steady_clock::now();
+
+    // completed readbacks are copied out of the PBO and encoded on the worker pool
+    glCapture capture([&](int i, const unsigned char* rgba, int w, int h) {
+        auto pixels = std::make_shared<std::vector<unsigned char>>(rgba, rgba + (size_t)w * h * 4);
+        encoders.wait_below(max_in_flight);
+        encoders.submit([=, &settings, &y4m] {
+            switch (settings.format) {
+            case SWEEP_PNG:
+                WritePNG(FrameName(settings.prefix, i, "png"), pixels->data(), w, h);
+                break;
+            case SWEEP_RAW:
+                WriteRaw(FrameName(settings.prefix, i, "raw"), pixels->data(), w, h);
+                break;
+            case SWEEP_Y4M: {
+                std::vector<unsigned char> yuv;
+                RGBAtoYUV420(pixels->data(), w, h, yuv);
+                y4m.Write(i, std::move(yuv));
+                break;
+            }
+            }
+        });
+    }, 3, settings.async_readback);
+
+    for (int i = 0; i < settings.frames; i++) {
+        float t = (settings.frames > 1) ? (float)i / (float)(settings.frames - 1) : 0.0f;
+        apply(i, t);
+
+        target.Bind();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        render(width, height);
+        capture.Capture(0, 0, width, height, i);       // frame i is transferred while frame i+1 renders
+        target.Unbind();
+        capture.Poll();
+    }
+    capture.Flush();
+    encoders.wait();
+    if (settings.format == SWEEP_Y4M) y4m.Close();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Exported " << settings.frames << " frames (" << width << "x" << height << ") in " << seconds
+        << " s (" << settings.frames / seconds << " fps)" << std::endl;
+    return true;
+}
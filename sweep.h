@@ -0,0 +1,34 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+enum SweepMode { SWEEP_SLICE_X = 0, SWEEP_SLICE_Y, SWEEP_SLICE_Z, SWEEP_ORBIT };
+enum SweepFormat { SWEEP_PNG = 0, SWEEP_RAW, SWEEP_Y4M };
+
+/// <summary>
+/// Parameters describing an animated sweep through the volume (or around it with the camera)
+/// </summary>
+struct SweepSettings {
+    int mode = SWEEP_SLICE_Z;                           // which slice is animated (or SWEEP_ORBIT to rotate the 3D camera)
+    int format = SWEEP_PNG;                             // numbered PNG/raw images or a single Y4M stream
+    int view = 0;                                       // viewport to export (see ViewId in glOrthoView.cpp, 4 = all four quadrants)
+    int frames = 120;                                   // number of frames in the sweep
+    int width = 1024;                                   // resolution of the exported frames
+    int height = 1024;
+    float orbit_degrees = 360.0f;                       // total camera rotation for SWEEP_ORBIT
+    int fps = 30;                                       // frame rate stored in the Y4M header
+    bool async_readback = true;                         // read frames back through the PBO ring (see glCapture)
+    std::string prefix = "sweep";                       // output file prefix (frames are named prefix_00000.png, ...)
+};
+
+/// <summary>
+/// Render a sweep off-screen and write it to disk. Frames are rendered on the calling (OpenGL) thread, read
+/// back asynchronously and encoded on a pool of worker threads, so rendering frame i+1 overlaps both the
+/// transfer and the encoding of frame i.
+/// </summary>
+/// <param name="settings">Sweep parameters</param>
+/// <param name="apply">Called before rendering frame i with t in [0, 1]; updates the slice position or camera</param>
+/// <param name="render">Renders the selected view(s) into the currently bound framebuffer of size (width, height)</param>
+/// <returns>false if the render target or output files could not be created</returns>
+bool ExportSweep(const SweepSettings& settings, std::function<void(int i, float t)> apply, std::function<void(int width, int height)> render);
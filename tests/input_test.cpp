@@ -0,0 +1,137 @@
+// Replays mouse event sequences through InputQueue and ProcessInput() without a window and checks the drag state
+
+#include "input.h"
+
+#include <iostream>
+
+static int failures = 0;
+
+static void Check(bool condition, const char* what) {
+    if (!condition) {
+        std::cout << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+/// <summary>
+/// Right press, two moves and a release orbit the camera by the total displacement and select nothing
+/// </summary>
+static void TestOrbit() {
+    InputQueue queue;
+    InputState state;
+    double orbit_x = 0.0, orbit_y = 0.0;
+    int orbits = 0;
+    InputHandlers handlers;
+    handlers.orbit = [&](double dx, double dy) { orbit_x += dx; orbit_y += dy; orbits++; };
+
+    double sx = 0.0, sy = 0.0;
+    bool moved;
+    queue.Move(100.0, 100.0);
+    queue.Button(INPUT_BUTTON_RIGHT, INPUT_PRESS, 0);
+    ProcessInput(state, queue.Drain(), handlers, sx, sy, moved);
+    Check(state.right_pressed, "right press starts an orbit");
+
+    queue.Move(110.0, 95.0);
+    queue.Move(120.0, 90.0);                                            // coalesced with the previous move
+    bool selected = ProcessInput(state, queue.Drain(), handlers, sx, sy, moved);
+    Check(moved, "orbit moves the view");
+    Check(!selected, "orbit does not select a position");
+    Check(orbits == 1 && orbit_x == 20.0 && orbit_y == -10.0, "orbit receives the coalesced displacement");
+
+    queue.Button(INPUT_BUTTON_RIGHT, INPUT_RELEASE, 0);
+    queue.Move(200.0, 200.0);
+    ProcessInput(state, queue.Drain(), handlers, sx, sy, moved);
+    Check(!state.right_pressed, "right release ends the orbit");
+    Check(!moved && orbits == 1, "moves after the release do not orbit");
+}
+
+/// <summary>
+/// Left press, move and release select the positions under the cursor
+/// </summary>
+static void TestSelect() {
+    InputQueue queue;
+    InputState state;
+    InputHandlers handlers;
+    double sx = 0.0, sy = 0.0;
+    bool moved;
+
+    queue.Move(10.0, 20.0);
+    queue.Button(INPUT_BUTTON_LEFT, INPUT_PRESS, 0);
+    queue.Move(30.0, 40.0);
+    queue.Button(INPUT_BUTTON_LEFT, INPUT_RELEASE, 0);
+    bool selected = ProcessInput(state, queue.Drain(), handlers, sx, sy, moved);
+    Check(selected && sx == 30.0 && sy == 40.0, "left drag selects the last position");
+    Check(!state.left_pressed && !moved, "left release ends the selection");
+}
+
+/// <summary>
+/// With a measurement tool selected a left drag draws it instead of selecting; over the GUI it does neither
+/// </summary>
+static void TestMeasurement() {
+    InputQueue queue;
+    InputState state;
+    InputHandlers handlers;
+    double sx = 0.0, sy = 0.0;
+    bool moved;
+
+    state.roi_tool = 1;
+    queue.Move(5.0, 6.0);
+    queue.Button(INPUT_BUTTON_LEFT, INPUT_PRESS, 0);
+    queue.Move(50.0, 60.0);
+    bool selected = ProcessInput(state, queue.Drain(), handlers, sx, sy, moved);
+    Check(!selected && state.roi_drag, "left drag with a tool draws a measurement");
+    Check(state.roi_screen[0] == 5.0f && state.roi_screen[1] == 6.0f &&
+          state.roi_screen[2] == 50.0f && state.roi_screen[3] == 60.0f, "measurement spans the drag");
+
+    queue.Button(INPUT_BUTTON_LEFT, INPUT_RELEASE, 0);
+    ProcessInput(state, queue.Drain(), handlers, sx, sy, moved);
+    Check(!state.roi_drag, "left release ends the measurement");
+
+    state.gui_focused = true;
+    queue.Button(INPUT_BUTTON_LEFT, INPUT_PRESS, 0);
+    ProcessInput(state, queue.Drain(), handlers, sx, sy, moved);
+    Check(!state.roi_drag, "no measurement is drawn over the GUI");
+}
+
+/// <summary>
+/// Shift + left drag rotates the oblique plane only while the plane is shown; ctrl + left drag starts a crop drag
+/// </summary>
+static void TestModifiers() {
+    InputQueue queue;
+    InputState state;
+    int rotations = 0;
+    InputHandlers handlers;
+    handlers.rotate = [&](double, double) { rotations++; };
+    double sx = 0.0, sy = 0.0;
+    bool moved;
+
+    queue.Button(INPUT_BUTTON_LEFT, INPUT_PRESS, INPUT_MOD_SHIFT);
+    queue.Move(1.0, 1.0);
+    queue.Button(INPUT_BUTTON_LEFT, INPUT_RELEASE, INPUT_MOD_SHIFT);
+    bool selected = ProcessInput(state, queue.Drain(), handlers, sx, sy, moved);
+    Check(selected && rotations == 0, "shift + left drag selects while the oblique plane is hidden");
+
+    state.oblique_enable = true;
+    queue.Button(INPUT_BUTTON_LEFT, INPUT_PRESS, INPUT_MOD_SHIFT);
+    queue.Move(2.0, 3.0);
+    selected = ProcessInput(state, queue.Drain(), handlers, sx, sy, moved);
+    Check(!selected && moved && rotations == 1 && state.oblique_drag, "shift + left drag rotates the oblique plane");
+    queue.Button(INPUT_BUTTON_LEFT, INPUT_RELEASE, INPUT_MOD_SHIFT);
+    ProcessInput(state, queue.Drain(), handlers, sx, sy, moved);
+    Check(!state.oblique_drag, "left release ends the rotation");
+
+    state.crop_enable = true;
+    queue.Move(7.0, 8.0);
+    queue.Button(INPUT_BUTTON_LEFT, INPUT_PRESS, INPUT_MOD_CONTROL);
+    ProcessInput(state, queue.Drain(), handlers, sx, sy, moved);
+    Check(state.crop_drag && state.x == 7.0 && state.y == 8.0, "ctrl + left press starts a crop drag at the cursor");
+}
+
+int main() {
+    TestOrbit();
+    TestSelect();
+    TestMeasurement();
+    TestModifiers();
+    if (failures == 0) std::cout << "input: all checks passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+#include "thumbnail.h"
+#include "npy.h"
+#include "cache.h"
+#include "downsample.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#define THUMBNAIL_ROWS 4                                // source rows averaged for every row of the thumbnail
+
+/// <summary>
+/// Thumbnails are cached as (height, width, 4) uint8 NumPy files
+/// </summary>
+static bool ReadCache(const std::filesystem::path& path, VolumeThumbnail& thumbnail) {
+    NpyHeader header;
+    if (!ReadNpyHeader(path.string(), header)) return false;
+    if (header.descr != "|u1" || header.shape.size() != 3 || header.shape[2] != 4) return false;
+
+    std::ifstream in(path, std::ios::binary);
+    in.seekg(header.offset);
+    std::vector<unsigned char> rgba(header.bytes());
+    in.read((char*)rgba.data(), rgba.size());
+    if (!in) return false;
+    thumbnail.height = (int)header.shape[0];
+    thumbnail.width = (int)header.shape[1];
+    thumbnail.rgba.swap(rgba);
+    return true;
+}
+
+static void WriteCache(const std::filesystem::path& path, const VolumeThumbnail& thumbnail) {
+    std::error_code ec;
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";                                      // renamed when complete, so a reader never sees a partial file
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        std::string header = MakeNpyHeader("|u1", { (size_t)thumbnail.height, (size_t)thumbnail.width, 4 });
+        out.write(header.data(), header.size());
+        out.write((const char*)thumbnail.rgba.data(), thumbnail.rgba.size());
+        if (!out) return;
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) std::filesystem::remove(tmp, ec);
+}
+
+static bool ExtractCentreSlice(const std::string& filename, int height, VolumeThumbnail& thumbnail) {
+    NpyHeader header;
+    if (!ReadNpyHeader(filename, header) || header.fortran_order) return false;
+    if (header.shape.size() != 3 && header.shape.size() != 4) return false;
+    size_t Z = header.shape[0], Y = header.shape[1], X = header.shape[2];
+    size_t C = (header.shape.size() == 4) ? header.shape[3] : 1;
+    if (X == 0 || Y == 0 || Z == 0 || C == 0 || height <= 0) return false;
+    size_t shown = (C >= 3) ? 3 : 1;                    // channels shown in the thumbnail
+
+    size_t out_h = std::min<size_t>(height, Y);
+    size_t out_w = std::clamp<size_t>((X * out_h + Y / 2) / Y, 1, std::min<size_t>(X, 4 * (size_t)height));
+    size_t row_values = X * C;
+    size_t row_bytes = row_values * header.itemsize;
+    size_t slice = header.offset + (Z / 2) * Y * row_bytes;
+
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) return false;
+    std::vector<unsigned char> raw(row_bytes);
+    std::vector<float> row(row_values), band(row_values);
+    std::vector<float> pixels(out_w * out_h * shown);
+    std::vector<size_t> column(X);                      // thumbnail column of every source column
+    for (size_t x = 0; x < X; x++) column[x] = x * out_w / X;
+    std::vector<float> weight(out_w, 0.0f);
+    for (size_t x = 0; x < X; x++) weight[column[x]] += 1.0f;
+
+    for (size_t oy = 0; oy < out_h; oy++) {
+        // average a few evenly spaced rows of the band covered by this thumbnail row (vertical box filter)
+        size_t y0 = oy * Y / out_h;
+        size_t y1 = std::max(y0 + 1, (oy + 1) * Y / out_h);
+        size_t n = std::min<size_t>(THUMBNAIL_ROWS, y1 - y0);
+        std::fill(band.begin(), band.end(), 0.0f);
+        for (size_t k = 0; k < n; k++) {
+            size_t y = y0 + (y1 - y0) * k / n;
+            in.seekg(slice + y * row_bytes);
+            in.read((char*)raw.data(), row_bytes);
+            if (!in || !NpyToFloat(header, raw.data(), row_values, row.data())) return false;
+            AccumulateRow(band.data(), row.data(), row_values);
+        }
+
+        // horizontal box filter
+        float* dst = &pixels[oy * out_w * shown];
+        for (size_t x = 0; x < X; x++) {
+            for (size_t c = 0; c < shown; c++)
+                dst[column[x] * shown + c] += band[x * C + c];
+        }
+        float scale = 1.0f / (float)n;
+        for (size_t ox = 0; ox < out_w; ox++) {
+            for (size_t c = 0; c < shown; c++)
+                dst[ox * shown + c] *= scale / weight[ox];
+        }
+    }
+
+    // stretch the values of the slice to [0, 255] (8-bit data is shown as is)
+    float lo = 0.0f, hi = 255.0f;
+    if (!(header.itemsize == 1 && header.kind != 'i')) {
+        auto range = std::minmax_element(pixels.begin(), pixels.end());
+        lo = *range.first;
+        hi = *range.second;
+    }
+    float s = (hi > lo) ? 255.0f / (hi - lo) : 0.0f;
+
+    thumbnail.width = (int)out_w;
+    thumbnail.height = (int)out_h;
+    thumbnail.rgba.resize(out_w * out_h * 4);
+    for (size_t p = 0; p < out_w * out_h; p++) {
+        for (size_t c = 0; c < 3; c++) {
+            float v = (pixels[p * shown + ((shown == 3) ? c : 0)] - lo) * s;
+            thumbnail.rgba[p * 4 + c] = (unsigned char)std::clamp(v + 0.5f, 0.0f, 255.0f);
+        }
+        thumbnail.rgba[p * 4 + 3] = 255;
+    }
+    return true;
+}
+
+bool MakeVolumeThumbnail(std::string filename, int height, VolumeThumbnail& thumbnail) {
+    std::filesystem::path cache = CacheFilename(filename, "thumbnails", "h" + std::to_string(height));
+    if (!cache.empty() && ReadCache(cache, thumbnail)) {
+        TouchCacheFile(cache.string());
+        return true;
+    }
+
+    if (!ExtractCentreSlice(filename, height, thumbnail)) return false;
+    if (!cache.empty()) WriteCache(cache, thumbnail);   // small: the cache is only trimmed at startup
+    return true;
+}
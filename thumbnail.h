@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Small RGBA preview of a volume file, shown by the file dialog
+/// </summary>
+struct VolumeThumbnail {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> rgba;                    // width x height RGBA pixels, top row first
+};
+
+/// <summary>
+/// Build a thumbnail of the centre XY slice of a NumPy volume (Z, Y, X) or (Z, Y, X, C) without loading it. Only
+/// a few rows of that slice are read for every row of the thumbnail, box-filtered down to the requested height and
+/// stretched to the value range of the slice (one channel is shown in grey, three or more as RGB). Thumbnails are
+/// kept in an on-disk cache keyed by the path, size and modification time of the file, so browsing a directory a
+/// second time does not touch the volumes at all.
+/// </summary>
+/// <param name="height">Height of the thumbnail in pixels (the width follows the aspect ratio of the slice)</param>
+/// <returns>false if the file is not a volume that can be previewed</returns>
+bool MakeVolumeThumbnail(std::string filename, int height, VolumeThumbnail& thumbnail);